@@ -20,7 +20,12 @@
 #include <functional>
 #include <string>
 #include <future>
-#include <queue>
+#include <atomic>
+#include <mutex>
+#include <condition_variable>
+#include <chrono>
+#include <deque>
+#include <vector>
 #include <tuple>
 #include <utility>
 #include <string_view>
@@ -32,9 +37,77 @@
 #include <asio2/base/detail/util.hpp>
 #include <asio2/base/detail/function_traits.hpp>
 #include <asio2/base/detail/buffer_wrap.hpp>
+#include <asio2/base/detail/mpsc_queue.hpp>
 
 namespace asio2::detail
 {
+	/**
+	 * what to do when a send is pushed but the send queue has reached the high watermark
+	 */
+	enum class send_policy : std::int8_t
+	{
+		notify,      // only fire the send pressure notification, the send is queued
+		block,       // block the calling thread until the queue falls to the low watermark
+		drop_newest, // the send is dropped, send returns false with error no_buffer_space
+		drop_oldest, // the send is queued, the oldest queued sends which are not being written are dropped
+		disconnect,  // the send is dropped and the connection is closed with error no_buffer_space
+	};
+
+	/**
+	 * the base class of the elements of the event queue
+	 */
+	class event_base : public mpsc_node
+	{
+	public:
+		virtual ~event_base() = default;
+
+		/**
+		 * execute the event
+		 */
+		virtual bool operator()() = 0;
+
+		/**
+		 * append the buffers of the data which will be sent by this event to the vector,
+		 * return false if this event is not a send event or the data can't be gathered.
+		 */
+		virtual bool gather(std::vector<asio::const_buffer>&) { return false; }
+
+		/**
+		 * notify the send result of the data which was gathered and written by another event,
+		 * or which was dropped by the send policy.
+		 */
+		virtual void complete(const error_code&, std::size_t) {}
+
+		/**
+		 * whether this event is a send event, only the send events are counted by the watermarks
+		 */
+		virtual bool is_send() const { return false; }
+
+		/**
+		 * the bytes of the data which will be sent by this event
+		 */
+		virtual std::size_t size() const { return 0; }
+
+		/**
+		 * the destination of the datagram which will be sent by this event, nullptr if the event
+		 * has no its own destination.
+		 */
+		virtual const asio::ip::udp::endpoint * endpoint() const { return nullptr; }
+	};
+
+	template<class Function>
+	class function_event final : public event_base
+	{
+	public:
+		template<class F>
+		explicit function_event(F&& f) : f_(std::forward<F>(f)) {}
+
+		virtual bool operator()() override { return f_(); }
+
+	protected:
+		Function f_;
+	};
+
 	template<class derived_t>
 	class event_queue_cp
 	{
@@ -47,7 +120,10 @@ namespace asio2::detail
 		/**
 		 * @destructor
 		 */
-		~event_queue_cp() = default;
+		~event_queue_cp()
+		{
+			this->_clear_events();
+		}
 
 	public:
 		/**
@@ -57,49 +133,276 @@ namespace asio2::detail
 		template<class Callback>
 		inline derived_t & push_event(Callback&& f)
 		{
+			using function_type = std::remove_cv_t<std::remove_reference_t<Callback>>;
+
+			return this->_push_event(std::unique_ptr<event_base>(
+				new function_event<function_type>(std::forward<Callback>(f))));
+		}
+
+		/**
+		 * @function : set the watermarks of the send queue, both the bytes and the number of the queued
+		 * sends are counted. when the queue reaches the high watermark, the send pressure notification
+		 * is fired with true and the send policy is applied, when the queue falls to the low watermark,
+		 * the send pressure notification is fired with false. 0 means no limit.
+		 */
+		inline derived_t & send_watermark(std::size_t high_bytes, std::size_t low_bytes,
+			std::size_t high_count = 0, std::size_t low_count = 0)
+		{
+			this->high_bytes_ = high_bytes;
+			this->low_bytes_  = (std::min)(low_bytes, high_bytes);
+			this->high_count_ = high_count;
+			this->low_count_  = (std::min)(low_count, high_count);
+			return (derive);
+		}
+
+		/**
+		 * @function : set the policy which is applied when the send queue reaches the high watermark
+		 */
+		inline derived_t & send_queue_policy(send_policy policy)
+		{
+			this->send_policy_ = policy;
+			return (derive);
+		}
+
+		/**
+		 * @function : get the policy which is applied when the send queue reaches the high watermark
+		 */
+		inline send_policy send_queue_policy() const { return this->send_policy_; }
+
+		/**
+		 * @function : get the bytes of the queued sends
+		 */
+		inline std::size_t send_queue_bytes() const { return this->queued_bytes_.load(std::memory_order_relaxed); }
+
+		/**
+		 * @function : get the number of the queued sends
+		 */
+		inline std::size_t send_queue_size() const { return this->queued_count_.load(std::memory_order_relaxed); }
+
+	protected:
+		/**
+		 * push a send event, the send policy is applied if the send queue has reached the high watermark,
+		 * return false if the send is dropped.
+		 */
+		inline bool _push_send_event(std::unique_ptr<event_base> e)
+		{
+			std::size_t size = e->size();
+
+			bool overflow =
+				(this->high_bytes_ && this->queued_bytes_.load(std::memory_order_relaxed) + size > this->high_bytes_) ||
+				(this->high_count_ && this->queued_count_.load(std::memory_order_relaxed) + 1    > this->high_count_);
+
+			if (overflow)
+			{
+				if (!this->pressured_.exchange(true, std::memory_order_acq_rel))
+					this->_post_send_pressure(true);
+
+				switch (this->send_policy_)
+				{
+				case send_policy::block:
+					// can't block the strand, otherwise the queue will never be consumed
+					if (!derive.io().strand().running_in_this_thread())
+					{
+						std::unique_lock<std::mutex> lock(this->pressure_mutex_);
+						while (this->pressured_.load(std::memory_order_acquire) && derive.is_started())
+						{
+							this->pressure_cv_.wait_for(lock, std::chrono::milliseconds(100));
+						}
+					}
+					break;
+				case send_policy::drop_newest:
+					set_last_error(asio::error::no_buffer_space);
+					e->complete(asio::error::no_buffer_space, 0);
+					return false;
+				case send_policy::disconnect:
+					asio::post(derive.io().strand(), make_allocator(derive.wallocator(),
+						[this, p = derive.selfptr()]() mutable
+					{
+						derive._do_disconnect(asio::error::no_buffer_space);
+					}));
+					set_last_error(asio::error::no_buffer_space);
+					e->complete(asio::error::no_buffer_space, 0);
+					return false;
+				default:
+					break;
+				}
+			}
+
+			this->queued_bytes_.fetch_add(size, std::memory_order_relaxed);
+			this->queued_count_.fetch_add(1, std::memory_order_relaxed);
+
+			this->_push_event(std::move(e));
+
+			if (overflow && this->send_policy_ == send_policy::drop_oldest)
+			{
+				asio::post(derive.io().strand(), make_allocator(derive.wallocator(),
+					[this, p = derive.selfptr()]() mutable
+				{
+					this->_drop_oldest_sends();
+				}));
+			}
+
+			return true;
+		}
+
+		/**
+		 * drop the oldest queued sends until the queue falls to the high watermark, the executing event
+		 * is not dropped. must be called in the strand.
+		 */
+		inline void _drop_oldest_sends()
+		{
+			this->_drain_incoming();
+
+			// the callbacks may push new events, so they are called after the dropping
+			std::vector<std::unique_ptr<event_base>> drops;
+
+			for (auto it = this->events_.begin(); it != this->events_.end() &&
+				((this->high_bytes_ && this->queued_bytes_.load(std::memory_order_relaxed) > this->high_bytes_) ||
+				 (this->high_count_ && this->queued_count_.load(std::memory_order_relaxed) > this->high_count_));)
+			{
+				if (it == this->events_.begin() || !(*it)->is_send())
+				{
+					++it;
+					continue;
+				}
+
+				drops.emplace_back(std::move(*it));
+				it = this->events_.erase(it);
+				this->_sub_pending();
+				this->_sub_queued(*(drops.back()));
+			}
+
+			for (auto & e : drops)
+			{
+				set_last_error(asio::error::operation_aborted);
+				e->complete(asio::error::operation_aborted, 0);
+			}
+		}
+
+		/**
+		 * the send event is removed from the event queue, fire the send pressure notification if
+		 * the queue falls to the low watermark. must be called in the strand.
+		 */
+		inline void _sub_queued(event_base& e)
+		{
+			if (!e.is_send())
+				return;
+
+			std::size_t bytes = this->queued_bytes_.fetch_sub(e.size(), std::memory_order_relaxed) - e.size();
+			std::size_t count = this->queued_count_.fetch_sub(1, std::memory_order_relaxed) - 1;
+
+			if (!this->pressured_.load(std::memory_order_relaxed))
+				return;
+
+			if ((this->high_bytes_ && bytes > this->low_bytes_) || (this->high_count_ && count > this->low_count_))
+				return;
+
+			if (!this->pressured_.exchange(false, std::memory_order_acq_rel))
+				return;
+
+			{
+				std::lock_guard<std::mutex> guard(this->pressure_mutex_);
+			}
+			this->pressure_cv_.notify_all();
+
+			this->_notify_send_pressure(false);
+		}
+
+		/**
+		 * the high edge which is reached by the other thread is posted into the strand, it's dropped
+		 * if the queue has fallen to the low watermark before it's executed.
+		 */
+		inline void _post_send_pressure(bool high)
+		{
+			if (derive.io().strand().running_in_this_thread())
+			{
+				this->_notify_send_pressure(high);
+				return;
+			}
+
+			asio::post(derive.io().strand(), make_allocator(derive.wallocator(),
+				[this, this_ptr = derive.selfptr(), high]() mutable
+			{
+				if (this->pressured_.load(std::memory_order_acquire) == high)
+					this->_notify_send_pressure(high);
+			}));
+		}
+
+		/**
+		 * fire the send pressure notification if it's changed since the last one, so the user always
+		 * sees high and low in turn. must be called in the strand.
+		 */
+		inline void _notify_send_pressure(bool high)
+		{
+			if (this->pressure_notified_ == high)
+				return;
+
+			this->pressure_notified_ = high;
+
+			std::shared_ptr<derived_t> this_ptr = derive.selfptr();
+			derive._fire_send_pressure(this_ptr, high);
+		}
+
+		inline derived_t & _push_event(std::unique_ptr<event_base> e)
+		{
 #if defined(ASIO2_SEND_CORE_ASYNC)
 			// Make sure we run on the strand
 			if (derive.io().strand().running_in_this_thread())
 			{
+				// the events pushed by other threads before this one must be queued first
 				bool empty = this->events_.empty();
-				this->events_.emplace(std::forward<Callback>(f));
+				this->_drain_incoming();
+				this->events_.emplace_back(std::move(e));
+				this->_add_pending();
 				if (empty)
 				{
-					(this->events_.front())();
+					(*(this->events_.front()))();
 				}
 				return (derive);
 			}
 
-			asio::post(derive.io().strand(), make_allocator(derive.wallocator(),
-				[this, p = derive.selfptr(), f = std::forward<Callback>(f)]() mutable
+			// push to the lock-free incoming queue directly, and only post a wakeup to the strand
+			// when there is no wakeup pending, so a burst of sends costs only one post.
+			this->incoming_.push(e.release());
+
+			if (!this->wakeup_.exchange(true, std::memory_order_acq_rel))
 			{
-				bool empty = this->events_.empty();
-				this->events_.emplace(std::move(f));
-				if (empty)
+				asio::post(derive.io().strand(), make_allocator(derive.wallocator(),
+					[this, p = derive.selfptr()]() mutable
 				{
-					(this->events_.front())();
-				}
-			}));
+					// must reset the flag before the draining, otherwise the event which is pushed
+					// after the draining and before the resetting will never be executed.
+					this->wakeup_.exchange(false, std::memory_order_acq_rel);
+
+					bool empty = this->events_.empty();
+					this->_drain_incoming();
+					if (empty && !this->events_.empty())
+					{
+						(*(this->events_.front()))();
+					}
+				}));
+			}
 
 			return (derive);
 #else
 			// Make sure we run on the strand
 			if (derive.io().strand().running_in_this_thread())
 			{
-				f();
+				(*e)();
 				return (derive);
 			}
 
 			asio::post(derive.io().strand(), make_allocator(derive.wallocator(),
-				[this, p = derive.selfptr(), f = std::forward<Callback>(f)]() mutable
+				[this, p = derive.selfptr(), e = std::move(e)]() mutable
 			{
-				f();
+				(*e)();
 			}));
 
 			return (derive);
 #endif
 		}
 
+	public:
 		/**
 		 * Removes an element from the front of the event queue.
 		 * and then execute the next element of the queue.
@@ -113,11 +416,14 @@ namespace asio2::detail
 			{
 				if (!this->events_.empty())
 				{
-					this->events_.pop();
+					std::unique_ptr<event_base> e = std::move(this->events_.front());
+					this->events_.pop_front();
+					this->_sub_pending();
+					this->_sub_queued(*e);
 
 					if (!this->events_.empty())
 					{
-						(this->events_.front())();
+						(*(this->events_.front()))();
 					}
 				}
 				return (derive);
@@ -128,11 +434,14 @@ namespace asio2::detail
 			{
 				if (!this->events_.empty())
 				{
-					this->events_.pop();
+					std::unique_ptr<event_base> e = std::move(this->events_.front());
+					this->events_.pop_front();
+					this->_sub_pending();
+					this->_sub_queued(*e);
 
 					if (!this->events_.empty())
 					{
-						(this->events_.front())();
+						(*(this->events_.front()))();
 					}
 				}
 			}));
@@ -145,10 +454,115 @@ namespace asio2::detail
 		}
 
 	protected:
-		derived_t                         & derive;
+		/**
+		 * destroy all the events which are not executed yet, the session must be not used by
+		 * any other thread.
+		 */
+		inline void _clear_events()
+		{
+			// the events which are pushed by other threads but not moved into the event queue yet
+			while (mpsc_node * n = this->incoming_.pop())
+				delete static_cast<event_base*>(n);
+
+			// the events which are not executed yet are no longer pending on the io
+			if (this->pending_io_ && !this->events_.empty())
+				this->pending_io_->pending_.fetch_sub(this->events_.size(), std::memory_order_relaxed);
+
+			this->events_.clear();
+
+			this->queued_bytes_.store(0, std::memory_order_relaxed);
+			this->queued_count_.store(0, std::memory_order_relaxed);
+			this->pressured_.store(false, std::memory_order_relaxed);
+			this->pressure_notified_ = false;
+		}
+
+		/**
+		 * move the events which are pushed by other threads into the event queue, must be called in the strand.
+		 */
+		inline void _drain_incoming()
+		{
+			while (mpsc_node * n = this->incoming_.pop())
+			{
+				this->events_.emplace_back(static_cast<event_base*>(n));
+				this->_add_pending();
+			}
+		}
+
+		/**
+		 * get the event which is next to the executing event, return nullptr if there is no such event.
+		 * used to coalesce the queued sends into one write, must be called in the strand.
+		 */
+		inline event_base * _next_queued_event()
+		{
+			return (this->events_.size() > 1 ? this->events_[1].get() : nullptr);
+		}
+
+		/**
+		 * remove the event which is next to the executing event from the queue and return it.
+		 */
+		inline std::unique_ptr<event_base> _detach_next_queued_event()
+		{
+			ASIO2_ASSERT(this->events_.size() > 1);
+			std::unique_ptr<event_base> e = std::move(this->events_[1]);
+			this->events_.erase(std::next(this->events_.begin()));
+			this->_sub_pending();
+			this->_sub_queued(*e);
+			return e;
+		}
+
+		inline void _add_pending()
+		{
+			if (!this->pending_io_)
+				this->pending_io_ = &(derive.io());
+			this->pending_io_->pending_.fetch_add(1, std::memory_order_relaxed);
+		}
+
+		inline void _sub_pending()
+		{
+			this->pending_io_->pending_.fetch_sub(1, std::memory_order_relaxed);
+		}
+
+	protected:
+		derived_t                               & derive;
+
+		std::deque<std::unique_ptr<event_base>>   events_;
 
-		std::queue<std::function<bool()>>   events_;
+		/// the events which are pushed by the threads other than the strand
+		mpsc_queue                                incoming_;
+
+		/// whether a wakeup is posted to the strand to move the incoming events into the event queue
+		std::atomic<bool>                         wakeup_{ false };
+
+		/// the watermarks of the send queue, 0 means no limit
+		std::size_t                               high_bytes_ = 0;
+		std::size_t                               low_bytes_  = 0;
+		std::size_t                               high_count_ = 0;
+		std::size_t                               low_count_  = 0;
+
+		send_policy                               send_policy_ = send_policy::notify;
+
+		/// the bytes and the number of the queued sends
+		std::atomic<std::size_t>                  queued_bytes_{ 0 };
+		std::atomic<std::size_t>                  queued_count_{ 0 };
+
+		/// whether the send queue has reached the high watermark and not fallen to the low watermark yet
+		std::atomic<bool>                         pressured_{ false };
+
+		/// the last send pressure notification which is fired to the user, only used in the strand
+		bool                                      pressure_notified_ = false;
+
+		/// used to block the caller thread for the send_policy::block
+		std::mutex                                pressure_mutex_;
+		std::condition_variable                   pressure_cv_;
+
+		/// the io which the queued events are counted on, used by iopool to choose the least loaded io
+		io_t                                    * pending_io_ = nullptr;
 	};
 }
 
+namespace asio2
+{
+	using send_policy = detail::send_policy;
+}
+
 #endif // !__ASIO2_EVENT_QUEUE_COMPONENT_HPP__
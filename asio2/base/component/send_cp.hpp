@@ -20,7 +20,7 @@
 #include <functional>
 #include <string>
 #include <future>
-#include <queue>
+#include <vector>
 #include <tuple>
 #include <utility>
 #include <string_view>
@@ -34,6 +34,7 @@
 #include <asio2/base/detail/buffer_wrap.hpp>
 
 #include <asio2/base/component/data_persistence_cp.hpp>
+#include <asio2/base/component/event_queue_cp.hpp>
 
 namespace asio2::detail
 {
@@ -64,6 +65,10 @@ namespace asio2::detail
 		 * std::array<PodType, N> : std::array<int,10> m; send(m);
 		 * std::vector<PodType, Allocator> : std::vector<float> m; send(m);
 		 * std::basic_string<Elem, Traits, Allocator> : std::string m; send(m);
+		 * Buffer sequence, all the buffers are written by one operation :
+		 * std::tuple<Ts...> : send(std::make_tuple(std::move(head), std::move(body))); the tuple owns the elements
+		 * std::vector<asio::const_buffer> , std::array<asio::const_buffer, N> : the memory which the buffers
+		 * refer to must remain valid until the sending is completed.
 		 * We do not provide synchronous send function,because the synchronous send code is very simple,
 		 * if you want use synchronous send data,you can do it like this (example):
 		 * asio::write(session_ptr->stream(), asio::buffer(std::string("abc")));
@@ -78,12 +83,8 @@ namespace asio2::detail
 				if (!this->derive.is_started())
 					asio::detail::throw_error(asio::error::not_connected);
 
-				this->derive.push_event([this,
-					data = this->derive._data_persistence(std::forward<T>(data))]() mutable
-				{
-					return this->derive._do_send(data, [](const error_code&, std::size_t) {});
-				});
-				return true;
+				return this->_push_send(this->derive._data_persistence(std::forward<T>(data)),
+					[](const error_code&, std::size_t) {});
 			}
 			catch (system_error & e) { set_last_error(e); }
 			catch (std::exception &) { set_last_error(asio::error::eof); }
@@ -130,11 +131,8 @@ namespace asio2::detail
 				if (!s)
 					asio::detail::throw_error(asio::error::invalid_argument);
 
-				this->derive.push_event([this, data = this->derive._data_persistence(s, count)]() mutable
-				{
-					return this->derive._do_send(data, [](const error_code&, std::size_t) {});
-				});
-				return true;
+				return this->_push_send(this->derive._data_persistence(s, count),
+					[](const error_code&, std::size_t) {});
 			}
 			catch (system_error & e) { set_last_error(e); }
 			catch (std::exception &) { set_last_error(asio::error::eof); }
@@ -167,13 +165,10 @@ namespace asio2::detail
 				if (!this->derive.is_started())
 					asio::detail::throw_error(asio::error::not_connected);
 
-				this->derive.push_event([this, data = this->derive._data_persistence(std::forward<T>(data)),
-					promise = std::move(promise)]() mutable
+				this->_push_send(this->derive._data_persistence(std::forward<T>(data)),
+					[promise = std::move(promise)](const error_code& ec, std::size_t bytes_sent) mutable
 				{
-					return this->derive._do_send(data, [&promise](const error_code& ec, std::size_t bytes_sent)
-					{
-						promise().set_value(std::pair<error_code, std::size_t>(ec, bytes_sent));
-					});
+					promise().set_value(std::pair<error_code, std::size_t>(ec, bytes_sent));
 				});
 			}
 			catch (system_error & e)
@@ -233,13 +228,10 @@ namespace asio2::detail
 				if (!s)
 					asio::detail::throw_error(asio::error::invalid_argument);
 
-				this->derive.push_event([this, data = this->derive._data_persistence(s, count),
-					promise = std::move(promise)]() mutable
+				this->_push_send(this->derive._data_persistence(s, count),
+					[promise = std::move(promise)](const error_code& ec, std::size_t bytes_sent) mutable
 				{
-					return this->derive._do_send(data, [&promise](const error_code& ec, std::size_t bytes_sent)
-					{
-						promise().set_value(std::pair<error_code, std::size_t>(ec, bytes_sent));
-					});
+					promise().set_value(std::pair<error_code, std::size_t>(ec, bytes_sent));
 				});
 			}
 			catch (system_error & e)
@@ -264,6 +256,7 @@ namespace asio2::detail
 		 * std::array<PodType, N> : std::array<int,10> m; send(m);
 		 * std::vector<PodType, Allocator> : std::vector<float> m; send(m);
 		 * std::basic_string<Elem, Traits, Allocator> : std::string m; send(m);
+		 * std::tuple<Ts...> , std::vector<asio::const_buffer> : see send(T&& data)
 		 * We do not provide synchronous send function,because the synchronous send code is very simple,
 		 * if you want use synchronous send data,you can do it like this (example):
 		 * asio::write(session_ptr->stream(), asio::buffer(std::string("abc")));
@@ -279,15 +272,11 @@ namespace asio2::detail
 				if (!this->derive.is_started())
 					asio::detail::throw_error(asio::error::not_connected);
 
-				this->derive.push_event([this, data = this->derive._data_persistence(std::forward<T>(data)),
-					fn = std::forward<Callback>(fn)]() mutable
+				return this->_push_send(this->derive._data_persistence(std::forward<T>(data)),
+					[fn = std::forward<Callback>(fn)](const error_code&, std::size_t bytes_sent) mutable
 				{
-					return this->derive._do_send(data, [&fn](const error_code&, std::size_t bytes_sent)
-					{
-						callback_helper::call(fn, bytes_sent);
-					});
+					callback_helper::call(fn, bytes_sent);
 				});
-				return true;
 			}
 			catch (system_error & e) { set_last_error(e); }
 			catch (std::exception &) { set_last_error(asio::error::eof); }
@@ -337,21 +326,92 @@ namespace asio2::detail
 				if (!s)
 					asio::detail::throw_error(asio::error::invalid_argument);
 
-				this->derive.push_event([this, data = this->derive._data_persistence(s, count),
-					fn = std::forward<Callback>(fn)]() mutable
+				return this->_push_send(this->derive._data_persistence(s, count),
+					[fn = std::forward<Callback>(fn)](const error_code&, std::size_t bytes_sent) mutable
 				{
-					return this->derive._do_send(data, [&fn](const error_code&, std::size_t bytes_sent)
-					{
-						callback_helper::call(fn, bytes_sent);
-					});
+					callback_helper::call(fn, bytes_sent);
 				});
-				return true;
 			}
 			catch (system_error & e) { set_last_error(e); }
 			catch (std::exception &) { set_last_error(asio::error::eof); }
 			return false;
 		}
 
+	protected:
+		/**
+		 * the queued send event, it owns the persisted data and the callback, so the data of
+		 * the queued sends can be gathered by the executing send to coalesce the writes.
+		 */
+		template<class Data, class Callback>
+		class send_event final : public event_base
+		{
+		public:
+			template<class D, class C>
+			send_event(derived_t& d, D&& data, C&& callback)
+				: derive(d), data_(std::forward<D>(data)), callback_(std::forward<C>(callback))
+			{
+				if constexpr (is_tuple<Data>::value || asio::is_const_buffer_sequence<Data>::value ||
+					is_buffer_able_v<Data>)
+				{
+					size_ = asio::buffer_size(to_buffers(data_));
+				}
+			}
+
+			virtual bool operator()() override
+			{
+				return derive._do_send(data_, [this](const error_code& ec, std::size_t bytes_sent)
+				{
+					callback_(ec, bytes_sent);
+				});
+			}
+
+			virtual bool gather(std::vector<asio::const_buffer>& buffers) override
+			{
+				// http and websocket messages can't be converted to buffers
+				if constexpr (is_tuple<Data>::value || asio::is_const_buffer_sequence<Data>::value ||
+					is_buffer_able_v<Data>)
+				{
+					auto&& b = to_buffers(data_);
+					buffers.insert(buffers.end(), asio::buffer_sequence_begin(b), asio::buffer_sequence_end(b));
+					return true;
+				}
+				else
+				{
+					std::ignore = buffers;
+					return false;
+				}
+			}
+
+			virtual void complete(const error_code& ec, std::size_t bytes_sent) override
+			{
+				callback_(ec, bytes_sent);
+			}
+
+			virtual bool is_send() const override { return true; }
+
+			virtual std::size_t size() const override { return size_; }
+
+		protected:
+			derived_t & derive;
+			Data        data_;
+			Callback    callback_;
+			std::size_t size_ = 0;
+		};
+
+		/**
+		 * return false if the send is dropped by the send policy, the callback is called with
+		 * error no_buffer_space in this case.
+		 */
+		template<class Data, class Callback>
+		inline bool _push_send(Data&& data, Callback&& callback)
+		{
+			using data_type     = std::remove_cv_t<std::remove_reference_t<Data>>;
+			using callback_type = std::remove_cv_t<std::remove_reference_t<Callback>>;
+
+			return this->derive._push_send_event(std::unique_ptr<event_base>(new send_event<data_type, callback_type>(
+				this->derive, std::forward<Data>(data), std::forward<Callback>(callback))));
+		}
+
 	protected:
 		derived_t                     & derive;
 	};
@@ -19,6 +19,8 @@
 #include <type_traits>
 #include <utility>
 #include <atomic>
+#include <cstdint>
+#include <cstddef>
 #include <fstream>
 
 namespace asio2::detail
@@ -45,13 +47,225 @@ namespace asio2::detail
 		static constexpr std::size_t size = N;
 	};
 
+	/**
+	 * the hit/miss counters of the handler_memory.
+	 * hits      : the allocations which are served by the storage of the handler_memory itself
+	 * pool_hits : the allocations which are served by the handler_pool (thread cache or free list)
+	 * misses    : the allocations which are delegated to the global heap
+	 */
+	struct handler_memory_stats
+	{
+		std::size_t hits      = 0;
+		std::size_t pool_hits = 0;
+		std::size_t misses    = 0;
+	};
+
+	// A process wide size class memory pool, used by the handler_memory when its own
+	// storage is in use. Each thread has a cache for each size class, the cache is
+	// refilled by taking the whole global free list of the size class and pushing back
+	// the blocks beyond the cache limit, and the block which can't be held by the cache
+	// is pushed to the global free list. Only push and take-all are used on the global
+	// free list, so it's lock-free and has no ABA problem.
+	// The blocks are never returned to the global heap, the pool grows to the peak usage.
+	class handler_pool
+	{
+	public:
+		static constexpr std::size_t min_size    = 64;
+		static constexpr std::size_t class_count = 6; // 64,128,256,512,1024,2048
+		static constexpr std::size_t max_size    = min_size << (class_count - 1);
+		static constexpr std::size_t cache_limit = 256; // the max blocks of each size class in a thread cache
+
+		/**
+		 * the pool is never destroyed, because the handlers may be destroyed after the static objects.
+		 */
+		static inline handler_pool & instance()
+		{
+			static handler_pool * pool = new handler_pool();
+			return (*pool);
+		}
+
+		/**
+		 * allocate a block which has size bytes at least, hit is set to false if the block is
+		 * allocated from the global heap.
+		 */
+		inline void* allocate(std::size_t size, bool& hit)
+		{
+			std::size_t index = size_class(size);
+			if (index < class_count)
+			{
+				thread_cache * cache = this->_cache();
+				block * b = nullptr;
+				if (cache)
+				{
+					if (!cache->heads[index])
+						this->_refill(*cache, index);
+					b = cache->heads[index];
+					if (b)
+					{
+						cache->heads[index] = b->next;
+						--(cache->counts[index]);
+					}
+				}
+				else
+				{
+					// the thread cache is destroyed already, use the global free list directly,
+					// take all and push back the rest.
+					b = this->frees_[index].exchange(nullptr, std::memory_order_acquire);
+					if (b && b->next)
+						this->_push_list(index, b->next);
+				}
+
+				if (b)
+				{
+					hit = true;
+					return b;
+				}
+
+				hit = false;
+				return ::operator new(min_size << index);
+			}
+
+			hit = false;
+			return ::operator new(size);
+		}
+
+		/**
+		 * the size must be equal to the size passed to allocate.
+		 */
+		inline void deallocate(void* pointer, std::size_t size)
+		{
+			std::size_t index = size_class(size);
+			if (index < class_count)
+			{
+				block * b = static_cast<block*>(pointer);
+				thread_cache * cache = this->_cache();
+				if (cache && cache->counts[index] < cache_limit)
+				{
+					b->next = cache->heads[index];
+					cache->heads[index] = b;
+					++(cache->counts[index]);
+				}
+				else
+				{
+					b->next = nullptr;
+					this->_push_list(index, b);
+				}
+				return;
+			}
+
+			::operator delete(pointer);
+		}
+
+		/**
+		 * get the size class index of the size, return class_count if the size is too large.
+		 */
+		static inline std::size_t size_class(std::size_t size)
+		{
+			std::size_t index = 0;
+			while (index < class_count && (min_size << index) < size)
+				++index;
+			return index;
+		}
+
+	protected:
+		handler_pool()
+		{
+			for (auto & f : this->frees_)
+				f.store(nullptr, std::memory_order_relaxed);
+		}
+
+		struct block
+		{
+			block * next;
+		};
+
+		struct thread_cache
+		{
+			explicit thread_cache(std::int8_t & state) : state_(state) { state_ = 1; }
+
+			~thread_cache()
+			{
+				state_ = 2;
+				for (std::size_t i = 0; i < class_count; ++i)
+				{
+					if (heads[i])
+						handler_pool::instance()._push_list(i, heads[i]);
+				}
+			}
+
+			std::int8_t & state_;
+			block       * heads [class_count] = {};
+			std::size_t   counts[class_count] = {};
+		};
+
+		/**
+		 * return nullptr if the thread cache of the calling thread is destroyed already.
+		 */
+		inline thread_cache * _cache()
+		{
+			// 0 : not constructed, 1 : alive, 2 : destroyed
+			thread_local std::int8_t state = 0;
+			if (state == 2)
+				return nullptr;
+			thread_local thread_cache cache(state);
+			return (&cache);
+		}
+
+		/**
+		 * take the global free list into the empty thread cache, the cache keeps cache_limit blocks at
+		 * most and the rest is pushed back, so a thread can't hoard the whole pool.
+		 */
+		inline void _refill(thread_cache & cache, std::size_t index)
+		{
+			block * first = this->frees_[index].exchange(nullptr, std::memory_order_acquire);
+			std::size_t count = 0;
+			if (first)
+			{
+				block * last = first;
+				count = 1;
+				while (last->next && count < cache_limit)
+				{
+					last = last->next;
+					++count;
+				}
+				if (last->next)
+				{
+					this->_push_list(index, last->next);
+					last->next = nullptr;
+				}
+			}
+			cache.heads [index] = first;
+			cache.counts[index] = count;
+		}
+
+		/**
+		 * push a list of blocks to the global free list, the last block's next must be nullptr.
+		 */
+		inline void _push_list(std::size_t index, block * first)
+		{
+			block * last = first;
+			while (last->next)
+				last = last->next;
+
+			block * head = this->frees_[index].load(std::memory_order_relaxed);
+			do
+			{
+				last->next = head;
+			} while (!this->frees_[index].compare_exchange_weak(head, first,
+				std::memory_order_release, std::memory_order_relaxed));
+		}
+
+	protected:
+		std::atomic<block*> frees_[class_count];
+	};
+
 	template<typename SizeN = size_op<allocator_size>, typename IsAtomicUse = std::false_type>
 	class handler_memory;
 
 	// Class to manage the memory to be used for handler-based custom allocation.
 	// It contains a single block of memory which may be returned for allocation
 	// requests. If the memory is in use when an allocation request is made, the
-	// allocator delegates allocation to the global heap.
+	// allocator delegates allocation to the handler_pool.
 	template<typename SizeN>
 	class handler_memory<SizeN, std::false_type>
 	{
@@ -64,18 +278,22 @@ namespace asio2::detail
 		inline void* allocate(std::size_t size)
 		{
 			//log_max_size(size);
-			if (!in_use_ && size < sizeof(storage_))
+			if (!in_use_ && size <= sizeof(storage_))
 			{
 				in_use_ = true;
+				++hits_;
 				return &storage_;
 			}
 			else
 			{
-				return ::operator new(size);
+				bool hit;
+				void* p = handler_pool::instance().allocate(size, hit);
+				++(hit ? pool_hits_ : misses_);
+				return p;
 			}
 		}
 
-		inline void deallocate(void* pointer)
+		inline void deallocate(void* pointer, std::size_t size)
 		{
 			if (pointer == &storage_)
 			{
@@ -83,16 +301,31 @@ namespace asio2::detail
 			}
 			else
 			{
-				::operator delete(pointer);
+				handler_pool::instance().deallocate(pointer, size);
 			}
 		}
 
+		/**
+		 * get the hit/miss counters
+		 */
+		inline handler_memory_stats stats() const
+		{
+			handler_memory_stats s;
+			s.hits      = hits_;
+			s.pool_hits = pool_hits_;
+			s.misses    = misses_;
+			return s;
+		}
+
 	private:
 		// Storage space used for handler-based custom memory allocation.
 		typename std::aligned_storage<SizeN::size>::type storage_;
 
 		// Whether the handler-based custom allocation storage has been used.
 		bool in_use_;
+
+		// The hit/miss counters.
+		std::size_t hits_ = 0, pool_hits_ = 0, misses_ = 0;
 	};
 
 	template<typename SizeN>
@@ -107,34 +340,53 @@ namespace asio2::detail
 		inline void* allocate(std::size_t size)
 		{
 			//log_max_size(size);
-			if (!in_use_.test_and_set() && size < sizeof(storage_))
+			if (size <= sizeof(storage_) && !in_use_.test_and_set(std::memory_order_acquire))
 			{
+				hits_.fetch_add(1, std::memory_order_relaxed);
 				return &storage_;
 			}
 			else
 			{
-				return ::operator new(size);
+				bool hit;
+				void* p = handler_pool::instance().allocate(size, hit);
+				(hit ? pool_hits_ : misses_).fetch_add(1, std::memory_order_relaxed);
+				return p;
 			}
 		}
 
-		inline void deallocate(void* pointer)
+		inline void deallocate(void* pointer, std::size_t size)
 		{
 			if (pointer == &storage_)
 			{
-				in_use_.clear();
+				in_use_.clear(std::memory_order_release);
 			}
 			else
 			{
-				::operator delete(pointer);
+				handler_pool::instance().deallocate(pointer, size);
 			}
 		}
 
+		/**
+		 * get the hit/miss counters
+		 */
+		inline handler_memory_stats stats() const
+		{
+			handler_memory_stats s;
+			s.hits      = hits_.load(std::memory_order_relaxed);
+			s.pool_hits = pool_hits_.load(std::memory_order_relaxed);
+			s.misses    = misses_.load(std::memory_order_relaxed);
+			return s;
+		}
+
 	private:
 		// Storage space used for handler-based custom memory allocation.
 		typename std::aligned_storage<SizeN::size>::type storage_;
 
 		// Whether the handler-based custom allocation storage has been used.
 		std::atomic_flag in_use_{ ATOMIC_FLAG_INIT };
+
+		// The hit/miss counters.
+		std::atomic<std::size_t> hits_{ 0 }, pool_hits_{ 0 }, misses_{ 0 };
 	};
 
 	// The allocator to be associated with the handler objects. This allocator only
@@ -171,9 +423,9 @@ namespace asio2::detail
 			return static_cast<T*>(memory_.allocate(sizeof(T) * n));
 		}
 
-		inline void deallocate(T* p, std::size_t /*n*/) const
+		inline void deallocate(T* p, std::size_t n) const
 		{
-			return memory_.deallocate(p);
+			return memory_.deallocate(p, sizeof(T) * n);
 		}
 
 	private:
@@ -18,6 +18,8 @@
 #include <cstddef>
 #include <limits>
 #include <memory>
+#include <array>
+#include <tuple>
 #include <type_traits>
 
 #include <asio2/base/selector.hpp>
@@ -70,6 +72,41 @@ namespace asio2
 			}
 		};
 
+		template<typename>
+		struct is_tuple : std::false_type {};
+
+		template<typename... Ts>
+		struct is_tuple<std::tuple<Ts...>> : std::true_type {};
+
+		/**
+		 * convert the persisted send data to a buffer sequence which can be written by one operation.
+		 * std::tuple<Ts...>      : each element is converted by asio::buffer, eg : the header and the body
+		 * const buffer sequence  : eg : std::vector<asio::const_buffer>, std::array<asio::const_buffer, N>
+		 * others                 : asio::buffer(data)
+		 */
+		template<class Data>
+		inline decltype(auto) to_buffers(Data& data)
+		{
+			using data_type = std::remove_cv_t<std::remove_reference_t<Data>>;
+			if constexpr (is_tuple<data_type>::value)
+			{
+				return std::apply([](auto&... args)
+				{
+					return std::array<asio::const_buffer, sizeof...(args)>{ asio::const_buffer(asio::buffer(args))... };
+				}, data);
+			}
+			else if constexpr (
+				!std::is_convertible_v<data_type, asio::const_buffer> &&
+				asio::is_const_buffer_sequence<data_type>::value)
+			{
+				return (const_cast<const data_type&>(data));
+			}
+			else
+			{
+				return asio::buffer(data);
+			}
+		}
+
 		struct empty_buffer
 		{
 			using size_type = std::size_t;
@@ -0,0 +1,150 @@
+/*
+ * COPYRIGHT (C) 2017-2019, zhllxt
+ *
+ * author   : zhllxt
+ * email    : 37792738@qq.com
+ *
+ * Distributed under the GNU GENERAL PUBLIC LICENSE Version 3, 29 June 2007
+ * (See accompanying file LICENSE or see <http://www.gnu.org/licenses/>)
+ */
+
+#ifndef __ASIO2_CPU_AFFINITY_HPP__
+#define __ASIO2_CPU_AFFINITY_HPP__
+
+#if defined(_MSC_VER) && (_MSC_VER >= 1200)
+#pragma once
+#endif // defined(_MSC_VER) && (_MSC_VER >= 1200)
+
+#include <cstdint>
+#include <string>
+#include <vector>
+#include <fstream>
+#include <sstream>
+#include <algorithm>
+
+#include <asio2/base/selector.hpp>
+#include <asio2/base/error.hpp>
+
+#if defined(__unix__) || defined(__linux__)
+	#include <pthread.h>
+	#include <sched.h>
+#endif
+
+namespace asio2::detail
+{
+	/**
+	 * @function : parse the linux cpu list format, eg : "0-3,8,10-11"
+	 */
+	inline std::vector<int> parse_cpu_list(const std::string & s)
+	{
+		std::vector<int> cpus;
+		std::istringstream stream(s);
+		std::string item;
+		while (std::getline(stream, item, ','))
+		{
+			if (item.empty() || item == "\n")
+				continue;
+			try
+			{
+				std::string::size_type pos = item.find('-');
+				int first = std::stoi(item.substr(0, pos));
+				int last = (pos == std::string::npos) ? first : std::stoi(item.substr(pos + 1));
+				for (int i = first; i <= last; ++i)
+					cpus.emplace_back(i);
+			}
+			catch (std::exception &) {}
+		}
+		return cpus;
+	}
+
+	/**
+	 * @function : get the cpu cores which belong to the numa node, return empty if the node is not exists
+	 */
+	inline std::vector<int> numa_node_cpus(int node)
+	{
+		std::vector<int> cpus;
+		if (node < 0)
+			return cpus;
+#if defined(__linux__)
+		std::ifstream file("/sys/devices/system/node/node" + std::to_string(node) + "/cpulist");
+		std::string s;
+		if (file && std::getline(file, s))
+			cpus = parse_cpu_list(s);
+#elif defined(_WIN32) || defined(_WIN64) || defined(_WINDOWS_) || defined(WIN32)
+		ULONGLONG mask = 0;
+		if (::GetNumaNodeProcessorMask(static_cast<UCHAR>(node), &mask))
+		{
+			for (int i = 0; i < 64; ++i)
+			{
+				if (mask & (ULONGLONG(1) << i))
+					cpus.emplace_back(i);
+			}
+		}
+#endif
+		return cpus;
+	}
+
+	/**
+	 * @function : get the numa node which the cpu core belongs to, return -1 if unknown
+	 */
+	inline int numa_node_of_cpu(int cpu)
+	{
+		if (cpu < 0)
+			return -1;
+#if defined(__linux__) || defined(_WIN32) || defined(_WIN64) || defined(_WINDOWS_) || defined(WIN32)
+		// the node number is small, 64 is enough for all the machines we know
+		for (int node = 0; node < 64; ++node)
+		{
+			std::vector<int> cpus = numa_node_cpus(node);
+			if (cpus.empty())
+				continue;
+			if (std::find(cpus.begin(), cpus.end(), cpu) != cpus.end())
+				return node;
+		}
+#endif
+		return -1;
+	}
+
+	/**
+	 * @function : bind the calling thread to the cpu core
+	 */
+	inline bool set_thread_affinity(int cpu)
+	{
+		if (cpu < 0)
+			return false;
+#if defined(__linux__)
+		if (cpu >= CPU_SETSIZE)
+		{
+			set_last_error(asio::error::invalid_argument);
+			return false;
+		}
+		cpu_set_t cpuset;
+		CPU_ZERO(&cpuset);
+		CPU_SET(cpu, &cpuset);
+		int ret = ::pthread_setaffinity_np(::pthread_self(), sizeof(cpu_set_t), &cpuset);
+		if (ret != 0)
+		{
+			set_last_error(ret);
+			return false;
+		}
+		return true;
+#elif defined(_WIN32) || defined(_WIN64) || defined(_WINDOWS_) || defined(WIN32)
+		if (cpu >= static_cast<int>(sizeof(DWORD_PTR) * 8))
+		{
+			set_last_error(asio::error::invalid_argument);
+			return false;
+		}
+		if (::SetThreadAffinityMask(::GetCurrentThread(), DWORD_PTR(1) << cpu) == 0)
+		{
+			set_last_error(static_cast<int>(::GetLastError()));
+			return false;
+		}
+		return true;
+#else
+		set_last_error(asio::error::operation_not_supported);
+		return false;
+#endif
+	}
+}
+
+#endif // !__ASIO2_CPU_AFFINITY_HPP__
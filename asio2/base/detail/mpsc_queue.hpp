@@ -0,0 +1,121 @@
+/*
+ * COPYRIGHT (C) 2017-2019, zhllxt
+ *
+ * author   : zhllxt
+ * email    : 37792738@qq.com
+ *
+ * Distributed under the GNU GENERAL PUBLIC LICENSE Version 3, 29 June 2007
+ * (See accompanying file LICENSE or see <http://www.gnu.org/licenses/>)
+ */
+
+#ifndef __ASIO2_MPSC_QUEUE_HPP__
+#define __ASIO2_MPSC_QUEUE_HPP__
+
+#if defined(_MSC_VER) && (_MSC_VER >= 1200)
+#pragma once
+#endif // defined(_MSC_VER) && (_MSC_VER >= 1200)
+
+#include <atomic>
+
+namespace asio2::detail
+{
+	/**
+	 * the node of the mpsc_queue, the element must derive from this class.
+	 */
+	class mpsc_node
+	{
+	public:
+		std::atomic<mpsc_node*> mpsc_next_{ nullptr };
+	};
+
+	/// see : http://www.1024cores.net/home/lock-free-algorithms/queues/intrusive-mpsc-node-based-queue
+
+	/**
+	 * intrusive lock-free multi producer single consumer queue, the queue doesn't own the nodes.
+	 * push can be called in any thread, pop and empty can only be called in the consumer thread.
+	 */
+	class mpsc_queue
+	{
+	public:
+		/**
+		 * @constructor
+		 */
+		mpsc_queue() : head_(&stub_), tail_(&stub_) {}
+
+		/**
+		 * @destructor
+		 */
+		~mpsc_queue() = default;
+
+		mpsc_queue(const mpsc_queue&) = delete;
+		mpsc_queue& operator=(const mpsc_queue&) = delete;
+
+		/**
+		 * push a node to the tail of the queue, it's multi thread safed.
+		 */
+		inline void push(mpsc_node* n)
+		{
+			n->mpsc_next_.store(nullptr, std::memory_order_relaxed);
+			mpsc_node* prev = head_.exchange(n, std::memory_order_acq_rel);
+			prev->mpsc_next_.store(n, std::memory_order_release);
+		}
+
+		/**
+		 * pop a node from the front of the queue, return nullptr if the queue is empty or
+		 * a producer is in the middle of the push (the producer will notify the consumer again).
+		 */
+		inline mpsc_node* pop()
+		{
+			mpsc_node* tail = tail_;
+			mpsc_node* next = tail->mpsc_next_.load(std::memory_order_acquire);
+
+			if (tail == &stub_)
+			{
+				if (!next)
+					return nullptr;
+
+				tail_ = next;
+				tail = next;
+				next = next->mpsc_next_.load(std::memory_order_acquire);
+			}
+
+			if (next)
+			{
+				tail_ = next;
+				return tail;
+			}
+
+			if (tail != head_.load(std::memory_order_acquire))
+				return nullptr;
+
+			this->push(&stub_);
+
+			next = tail->mpsc_next_.load(std::memory_order_acquire);
+
+			if (next)
+			{
+				tail_ = next;
+				return tail;
+			}
+
+			return nullptr;
+		}
+
+		/**
+		 * whether the queue is empty, can only be called in the consumer thread.
+		 */
+		inline bool empty() const
+		{
+			return (tail_ == &stub_ && head_.load(std::memory_order_acquire) == &stub_);
+		}
+
+	protected:
+		std::atomic<mpsc_node*> head_;
+
+		mpsc_node             * tail_;
+
+		mpsc_node               stub_;
+	};
+}
+
+#endif // !__ASIO2_MPSC_QUEUE_HPP__
@@ -0,0 +1,345 @@
+/*
+ * COPYRIGHT (C) 2017-2019, zhllxt
+ *
+ * author   : zhllxt
+ * email    : 37792738@qq.com
+ *
+ * Distributed under the GNU GENERAL PUBLIC LICENSE Version 3, 29 June 2007
+ * (See accompanying file LICENSE or see <http://www.gnu.org/licenses/>)
+ */
+
+#ifndef __ASIO2_TIMER_WHEEL_HPP__
+#define __ASIO2_TIMER_WHEEL_HPP__
+
+#if defined(_MSC_VER) && (_MSC_VER >= 1200)
+#pragma once
+#endif // defined(_MSC_VER) && (_MSC_VER >= 1200)
+
+#include <cstdint>
+#include <array>
+#include <bitset>
+#include <chrono>
+
+#include <asio2/base/selector.hpp>
+#include <asio2/base/error.hpp>
+
+#include <asio2/base/detail/allocator.hpp>
+
+namespace asio2::detail
+{
+	class timer_wheel;
+
+	/**
+	 * the node of the timer_wheel, the element must derive from this class. a node can be scheduled
+	 * once at a time, scheduling a linked node moves it to the new expiry.
+	 */
+	class timer_wheel_node
+	{
+		friend class timer_wheel;
+
+	public:
+		timer_wheel_node() = default;
+		virtual ~timer_wheel_node() = default;
+
+		timer_wheel_node(const timer_wheel_node&) = delete;
+		timer_wheel_node& operator=(const timer_wheel_node&) = delete;
+
+		/**
+		 * @function : check whether the node is scheduled
+		 */
+		inline bool is_linked() const { return (this->wheel_prev_ != nullptr); }
+
+	protected:
+		/**
+		 * called in the io thread when the node is expired, the node is unlinked already, so it can
+		 * be scheduled again or destroyed in this function.
+		 */
+		virtual void on_wheel_timer() = 0;
+
+	protected:
+		timer_wheel_node * wheel_prev_ = nullptr;
+		timer_wheel_node * wheel_next_ = nullptr;
+		std::uint64_t      wheel_expiry_ = 0;
+	};
+
+	/**
+	 * hierarchical timer wheel with 1 millisecond tick, all the nodes of an io are driven by one
+	 * steady_timer, the steady_timer is only armed when there are nodes, and it's armed to the next
+	 * tick which has nodes (or the next cascade tick), so the idle wheel never wakes up the thread.
+	 * level 0 : 256 slots of 1 ms, level 1~3 : 64 slots of 256 ms, 16 s, 17 min.
+	 * It's not thread safe, all the functions must be called in the strand of the io.
+	 */
+	class timer_wheel
+	{
+	public:
+		/**
+		 * @constructor
+		 */
+		timer_wheel(asio::io_context & context, asio::io_context::strand & strand)
+			: strand_(strand), timer_(context), start_(std::chrono::steady_clock::now())
+		{
+			for (auto & level : this->slots_)
+				for (auto & slot : level)
+					slot.wheel_prev_ = slot.wheel_next_ = &slot;
+			for (auto & slot : this->near_)
+				slot.wheel_prev_ = slot.wheel_next_ = &slot;
+		}
+
+		/**
+		 * @destructor
+		 */
+		~timer_wheel()
+		{
+			// the nodes are owned by the others, just unlink them
+			for (auto & level : this->slots_)
+				for (auto & slot : level)
+					this->_unlink_all(slot);
+			for (auto & slot : this->near_)
+				this->_unlink_all(slot);
+		}
+
+		timer_wheel(const timer_wheel&) = delete;
+		timer_wheel& operator=(const timer_wheel&) = delete;
+
+		/**
+		 * @function : schedule the node to be expired after delay milliseconds
+		 */
+		inline void schedule(timer_wheel_node & node, std::uint32_t delay)
+		{
+			if (node.is_linked())
+			{
+				this->_unlink(node);
+				--(this->count_);
+			}
+
+			// the ticks which are elapsed during the idle are skipped
+			if (this->count_ == 0)
+				this->now_ = (std::max)(this->now_, this->_elapsed());
+
+			// the expiry is counted from the real time, the wheel may lag behind it a little
+			node.wheel_expiry_ = (std::max)(this->_elapsed() + delay, this->now_ + 1);
+
+			this->_link(node);
+
+			++(this->count_);
+
+			this->_arm();
+		}
+
+		/**
+		 * @function : cancel the node, do nothing if it's not scheduled
+		 */
+		inline void cancel(timer_wheel_node & node)
+		{
+			if (!node.is_linked())
+				return;
+
+			this->_unlink(node);
+
+			if (--(this->count_) == 0)
+			{
+				error_code ec;
+				this->timer_.cancel(ec);
+				this->armed_ = 0;
+			}
+		}
+
+		/**
+		 * @function : get the number of the scheduled nodes
+		 */
+		inline std::size_t size() const { return this->count_; }
+
+	protected:
+		static constexpr std::size_t near_bits  = 8;
+		static constexpr std::size_t level_bits = 6;
+		static constexpr std::size_t levels     = 3;
+
+		static constexpr std::size_t near_size  = std::size_t(1) << near_bits;
+		static constexpr std::size_t level_size = std::size_t(1) << level_bits;
+
+		inline std::uint64_t _elapsed() const
+		{
+			return static_cast<std::uint64_t>(std::chrono::duration_cast<std::chrono::milliseconds>(
+				std::chrono::steady_clock::now() - this->start_).count());
+		}
+
+		inline void _link(timer_wheel_node & node)
+		{
+			std::uint64_t expiry = node.wheel_expiry_;
+			std::uint64_t delta = expiry - this->now_;
+
+			timer_wheel_node * slot = nullptr;
+
+			if (delta < near_size)
+			{
+				std::size_t index = static_cast<std::size_t>(expiry & (near_size - 1));
+				this->occupied_.set(index);
+				slot = &(this->near_[index]);
+			}
+			else
+			{
+				std::size_t level = 0;
+				for (; level < levels - 1; ++level)
+				{
+					if (delta < (std::uint64_t(1) << (near_bits + (level + 1) * level_bits)))
+						break;
+				}
+
+				// the longer delay is clamped to the last slot of the top level, it's cascaded again
+				std::uint64_t max_delta = (std::uint64_t(1) << (near_bits + levels * level_bits)) - 1;
+				if (delta > max_delta)
+					expiry = this->now_ + max_delta;
+
+				slot = &(this->slots_[level][static_cast<std::size_t>(
+					(expiry >> (near_bits + level * level_bits)) & (level_size - 1))]);
+			}
+
+			node.wheel_prev_ = slot->wheel_prev_;
+			node.wheel_next_ = slot;
+			slot->wheel_prev_->wheel_next_ = &node;
+			slot->wheel_prev_ = &node;
+		}
+
+		inline void _unlink(timer_wheel_node & node)
+		{
+			node.wheel_prev_->wheel_next_ = node.wheel_next_;
+			node.wheel_next_->wheel_prev_ = node.wheel_prev_;
+			node.wheel_prev_ = node.wheel_next_ = nullptr;
+		}
+
+		inline void _unlink_all(timer_wheel_node & slot)
+		{
+			while (slot.wheel_next_ != &slot)
+				this->_unlink(*(slot.wheel_next_));
+		}
+
+		/**
+		 * move the nodes of the slot to the lower level
+		 */
+		inline void _cascade(std::size_t level, std::size_t index)
+		{
+			timer_wheel_node & slot = this->slots_[level][index];
+			while (slot.wheel_next_ != &slot)
+			{
+				timer_wheel_node & node = *(slot.wheel_next_);
+				this->_unlink(node);
+				this->_link(node);
+			}
+		}
+
+		/**
+		 * process the tick now_
+		 */
+		inline void _tick()
+		{
+			std::size_t index = static_cast<std::size_t>(this->now_ & (near_size - 1));
+
+			if (index == 0)
+			{
+				for (std::size_t level = 0; level < levels; ++level)
+				{
+					std::size_t i = static_cast<std::size_t>(
+						(this->now_ >> (near_bits + level * level_bits)) & (level_size - 1));
+					this->_cascade(level, i);
+					if (i != 0)
+						break;
+				}
+			}
+
+			timer_wheel_node & slot = this->near_[index];
+			this->occupied_.reset(index);
+
+			// the node may be scheduled again in the callback, it's linked to a later tick
+			while (slot.wheel_next_ != &slot)
+			{
+				timer_wheel_node & node = *(slot.wheel_next_);
+				this->_unlink(node);
+				--(this->count_);
+				node.on_wheel_timer();
+			}
+		}
+
+		/**
+		 * get the next tick which has nodes, or the next cascade tick
+		 */
+		inline std::uint64_t _next_tick() const
+		{
+			std::uint64_t tick = this->now_ + 1;
+			for (; (tick & (near_size - 1)) != 0; ++tick)
+			{
+				if (this->occupied_.test(static_cast<std::size_t>(tick & (near_size - 1))))
+					break;
+			}
+			return tick;
+		}
+
+		inline void _arm()
+		{
+			if (this->count_ == 0)
+				return;
+
+			std::uint64_t tick = this->_next_tick();
+
+			// the timer is armed to an earlier tick already
+			if (this->armed_ != 0 && this->armed_ <= tick)
+				return;
+
+			this->armed_ = tick;
+
+			this->timer_.expires_at(this->start_ + std::chrono::milliseconds(tick));
+			this->timer_.async_wait(asio::bind_executor(this->strand_, make_allocator(this->allocator_,
+				[this, tick](const error_code & ec)
+			{
+				// the timer is canceled or armed to another tick
+				if (ec == asio::error::operation_aborted || this->armed_ != tick)
+					return;
+
+				this->armed_ = 0;
+
+				std::uint64_t elapsed = this->_elapsed();
+				while (this->now_ < elapsed && this->count_ > 0)
+				{
+					++(this->now_);
+					this->_tick();
+				}
+
+				if (this->count_ == 0)
+					this->now_ = (std::max)(this->now_, elapsed);
+
+				this->_arm();
+			})));
+		}
+
+	protected:
+		asio::io_context::strand                & strand_;
+
+		asio::steady_timer                        timer_;
+
+		std::chrono::steady_clock::time_point     start_;
+
+		/// the tick which is processed already
+		std::uint64_t                             now_ = 0;
+
+		/// the tick which the timer is armed to, 0 means not armed
+		std::uint64_t                             armed_ = 0;
+
+		std::size_t                               count_ = 0;
+
+		/// the list heads of the slots, the head is a node which is never expired
+		struct slot_head : public timer_wheel_node
+		{
+			void on_wheel_timer() override {}
+		};
+
+		std::array<slot_head, near_size>                              near_;
+
+		std::array<std::array<slot_head, level_size>, levels>         slots_;
+
+		/// whether the slot of the level 0 has nodes
+		std::bitset<near_size>                                        occupied_;
+
+		handler_memory<>                                              allocator_;
+	};
+}
+
+#endif // !__ASIO2_TIMER_WHEEL_HPP__
@@ -107,6 +107,34 @@ namespace asio2::detail
 		return (v);
 	}
 
+	/**
+	 * Endpoint Hash Function
+	 * The ipv4 address and port are packed into one integer and mixed by a multiply, the ipv6
+	 * endpoint hashes the address, port and scope id, the other bytes of the sockaddr (eg: the
+	 * padding and flowinfo) are ignored because they are not compared by the operator==.
+	 */
+	template<typename Endpoint>
+	inline std::size_t endpoint_hash(const Endpoint & e) noexcept
+	{
+		const asio::detail::socket_addr_type * addr = e.data();
+		if (addr->sa_family == ASIO_OS_DEF(AF_INET))
+		{
+			const asio::detail::sockaddr_in4_type * v4 =
+				reinterpret_cast<const asio::detail::sockaddr_in4_type *>(addr);
+			std::uint64_t v = (static_cast<std::uint64_t>(v4->sin_addr.s_addr) << 16) |
+				static_cast<std::uint64_t>(v4->sin_port);
+			v *= 0x9e3779b97f4a7c15ull;
+			return static_cast<std::size_t>(v ^ (v >> 32));
+		}
+
+		const asio::detail::sockaddr_in6_type * v6 =
+			reinterpret_cast<const asio::detail::sockaddr_in6_type *>(addr);
+		std::size_t v = bkdr_hash(reinterpret_cast<const unsigned char *>(&(v6->sin6_addr)), sizeof(v6->sin6_addr));
+		v = v * 131 + static_cast<std::size_t>(v6->sin6_port);
+		v = v * 131 + static_cast<std::size_t>(v6->sin6_scope_id);
+		return v;
+	}
+
 	// struct that ignores assignments
 	struct ignore
 	{
@@ -242,6 +270,16 @@ namespace asio2::detail
 	inline constexpr bool is_string_view_v = is_string_view<T>::value;
 
 
+	template<typename, typename = void>
+	struct is_buffer_able : std::false_type {};
+
+	template<typename T>
+	struct is_buffer_able<T, std::void_t<decltype(asio::buffer(std::declval<const T&>()))>> : std::true_type {};
+
+	template<class T>
+	inline constexpr bool is_buffer_able_v = is_buffer_able<T>::value;
+
+
 	template<typename T>
 	inline std::string to_string(T&& v)
 	{
@@ -325,7 +363,7 @@ namespace std
 		{
 			//return std::hash<std::string_view>()(std::string_view{
 			//	reinterpret_cast<std::string_view::const_pointer>(&s),sizeof(argument_type) });
-			return asio2::detail::bkdr_hash((const unsigned char *)(&s), sizeof(argument_type));
+			return asio2::detail::endpoint_hash(s);
 		}
 	};
 
@@ -19,24 +19,99 @@
 #include <thread>
 #include <mutex>
 #include <chrono>
+#include <atomic>
+#include <random>
+#include <functional>
+#include <future>
 #include <type_traits>
 
 #include <asio2/base/selector.hpp>
 
+#include <asio2/base/detail/cpu_affinity.hpp>
+#include <asio2/base/detail/timer_wheel.hpp>
+
 namespace asio2::detail
 {
+	template <class>                      class event_queue_cp;
+	template <class, class, class>        class session_impl_t;
+
+	/**
+	 * the policy used by iopool::get to choose the io_context for a new session
+	 */
+	enum class io_placement : std::int8_t
+	{
+		round_robin,    // choose the next io in turn
+		least_sessions, // choose the io which serves the fewest sessions
+		least_pending,  // choose the io which has the fewest queued send events
+		two_choices,    // choose the less loaded of two random ios (power of two choices)
+	};
+
 	class io_t
 	{
+		friend class iopool;
+		template <class>                      friend class event_queue_cp;
+		template <class, class, class>        friend class session_impl_t;
+
 	public:
-		io_t() : context_(1), strand_(context_) {}
+		io_t() : context_(1), strand_(context_), wheel_(context_, strand_) {}
 		~io_t() = default;
 
 		inline asio::io_context & context() { return this->context_; }
 		inline asio::io_context::strand &  strand() { return this->strand_; }
 
+		/**
+		 * @function : get the timer wheel of this io, it can only be used in the strand of this io.
+		 * The short and frequent timers of many objects (eg: the kcp update) share it instead of
+		 * arming a steady_timer for each of them.
+		 */
+		inline timer_wheel & wheel() { return this->wheel_; }
+
+		/**
+		 * @function : get the cpu core which the thread of this io is pinned to, -1 means not pinned
+		 */
+		inline int cpu() const { return this->cpu_; }
+
+		/**
+		 * @function : get the numa node which the thread of this io is running on, -1 means unknown
+		 * Memory which is first touched in this io thread will be allocated on this node by the os,
+		 * so you can allocate the per session state in the session's io thread (eg: in bind_connect
+		 * or by session_ptr->post(...)) to keep it local to the thread that serves it.
+		 */
+		inline int numa_node() const { return this->numa_node_; }
+
+		/**
+		 * @function : get the number of sessions which are served by this io
+		 */
+		inline std::size_t session_count() const { return this->sessions_.load(std::memory_order_relaxed); }
+
+		/**
+		 * @function : get the number of queued send events of all the sessions on this io
+		 */
+		inline std::size_t pending_count() const { return this->pending_.load(std::memory_order_relaxed); }
+
+		/**
+		 * @function : get the load of this io, used to compare the ios when choose a io for a new session
+		 */
+		inline std::size_t load() const { return (this->session_count() + this->pending_count()); }
+
 	protected:
 		asio::io_context context_;
 		asio::io_context::strand strand_;
+
+		/// the shared timer wheel of the objects which are served by this io
+		timer_wheel wheel_;
+
+		/// the cpu core which the io thread is pinned to
+		int cpu_ = -1;
+
+		/// the numa node of the cpu core
+		int numa_node_ = -1;
+
+		/// the number of sessions which are served by this io
+		std::atomic<std::size_t> sessions_{ 0 };
+
+		/// the number of queued send events of all the sessions on this io
+		std::atomic<std::size_t> pending_{ 0 };
 	};
 
 	/**
@@ -77,6 +152,10 @@ namespace asio2::detail
 			if (!this->works_.empty() || !this->threads_.empty())
 				return false;
 
+			// the result of the cpu pinning of each thread, the caller waits for them, so the cpu_of
+			// is right after start, and the error can be got by the caller's last error
+			std::vector<std::future<error_code>> pinned;
+
 			// Create a pool of threads to run all of the io_contexts. 
 			for (auto & io : this->ios_)
 			{
@@ -95,13 +174,33 @@ namespace asio2::detail
 
 				this->works_.emplace_back(io.context().get_executor());
 
+				std::promise<error_code> promise;
+				pinned.emplace_back(promise.get_future());
+
 				// start work thread
-				this->threads_.emplace_back([&io]()
+				this->threads_.emplace_back([&io, promise = std::move(promise)]() mutable
 				{
+					// pin the thread before run, so the memory used by this thread will be on the local node
+					error_code ec;
+					if (io.cpu_ >= 0 && !set_thread_affinity(io.cpu_))
+					{
+						ec = get_last_error();
+						io.cpu_ = -1;
+						io.numa_node_ = -1;
+					}
+					promise.set_value(ec);
+
 					io.context().run();
 				});
 			}
 
+			for (auto & f : pinned)
+			{
+				error_code ec = f.get();
+				if (ec)
+					set_last_error(ec);
+			}
+
 			this->stopped_ = false;
 
 			return true;
@@ -182,8 +281,95 @@ namespace asio2::detail
 		 */
 		inline io_t & get(std::size_t index = static_cast<std::size_t>(-1))
 		{
+			if (index < this->ios_.size())
+				return this->ios_[index];
+
+			switch (this->placement_)
+			{
+			case io_placement::least_sessions:
+				return this->_get_least(std::mem_fn(&io_t::session_count));
+			case io_placement::least_pending:
+				return this->_get_least(std::mem_fn(&io_t::pending_count));
+			case io_placement::two_choices:
+				return this->_get_two_choices();
+			default:
+				break;
+			}
+
 			// Use a round-robin scheme to choose the next io_context to use. 
-			return this->ios_[index < this->ios_.size() ? index : ((++(this->next_)) % this->ios_.size())];
+			return this->ios_[(this->next_.fetch_add(1, std::memory_order_relaxed) + 1) % this->ios_.size()];
+		}
+
+		/**
+		 * @function : set the policy used to choose the io_context for a new session, the default is round_robin
+		 */
+		inline void placement(io_placement policy)
+		{
+			this->placement_ = policy;
+		}
+
+		/**
+		 * @function : get the policy used to choose the io_context for a new session
+		 */
+		inline io_placement placement() const
+		{
+			return this->placement_;
+		}
+
+		/**
+		 * @function : get the io_context pool size
+		 */
+		inline std::size_t size() const
+		{
+			return this->ios_.size();
+		}
+
+		/**
+		 * @function : pin each io thread to a cpu core, the io thread i is pinned to cpus[i % cpus.size()]
+		 * must be called before the iopool is started, pass a empty vector to cancel the pinning.
+		 */
+		bool cpu_affinity(const std::vector<int> & cpus)
+		{
+			std::lock_guard<std::mutex> guard(this->mutex_);
+
+			if (!this->stopped_ || !this->threads_.empty())
+			{
+				set_last_error(asio::error::already_started);
+				return false;
+			}
+
+			for (std::size_t i = 0; i < this->ios_.size(); ++i)
+			{
+				io_t & io = this->ios_[i];
+				io.cpu_ = cpus.empty() ? -1 : cpus[i % cpus.size()];
+				io.numa_node_ = numa_node_of_cpu(io.cpu_);
+			}
+
+			return true;
+		}
+
+		/**
+		 * @function : pin the io threads to the cpu cores of the numa node
+		 * must be called before the iopool is started.
+		 */
+		bool numa_affinity(int node)
+		{
+			std::vector<int> cpus = numa_node_cpus(node);
+			if (cpus.empty())
+			{
+				set_last_error(asio::error::invalid_argument);
+				return false;
+			}
+			return this->cpu_affinity(cpus);
+		}
+
+		/**
+		 * @function : get the cpu core which the io thread of the index is pinned to, -1 means not pinned
+		 * or the pinning is failed, the error of the failed pinning is set to the last error of start.
+		 */
+		inline int cpu_of(std::size_t index) const
+		{
+			return (index < this->ios_.size() ? this->ios_[index].cpu() : -1);
 		}
 
 		/**
@@ -256,6 +442,42 @@ namespace asio2::detail
 			}
 		}
 
+	protected:
+		template<class LoadFn>
+		inline io_t & _get_least(LoadFn&& fn)
+		{
+			// start from the round-robin position, so the ios with the same load are used in turn
+			std::size_t size = this->ios_.size();
+			std::size_t first = this->next_.fetch_add(1, std::memory_order_relaxed) + 1;
+			std::size_t index = first % size;
+			std::size_t least = fn(this->ios_[index]);
+			for (std::size_t i = 1; i < size && least > 0; ++i)
+			{
+				std::size_t n = (first + i) % size;
+				std::size_t load = fn(this->ios_[n]);
+				if (load < least)
+				{
+					least = load;
+					index = n;
+				}
+			}
+			return this->ios_[index];
+		}
+
+		inline io_t & _get_two_choices()
+		{
+			std::size_t size = this->ios_.size();
+			if (size < 2)
+				return this->ios_.front();
+
+			thread_local static std::minstd_rand engine(static_cast<std::minstd_rand::result_type>(
+				std::hash<std::thread::id>()(std::this_thread::get_id())));
+
+			std::size_t a = engine() % size;
+			std::size_t b = (a + 1 + engine() % (size - 1)) % size;
+			return (this->ios_[b].load() < this->ios_[a].load() ? this->ios_[b] : this->ios_[a]);
+		}
+
 	protected:
 		/// threads to run all of the io_context
 		std::vector<std::thread>       threads_;
@@ -270,7 +492,10 @@ namespace asio2::detail
 		bool                           stopped_  = true;
 
 		/// The next io_context to use for a connection. 
-		std::size_t                    next_     = 0;
+		std::atomic<std::size_t>       next_     { 0 };
+
+		/// The policy used to choose the io_context for a connection.
+		io_placement                   placement_ = io_placement::round_robin;
 
 		// Give all the io_contexts work to do so that their run() functions will not 
 		// exit until they are explicitly stopped. 
@@ -283,10 +508,66 @@ namespace asio2::detail
 		iopool_cp(std::size_t concurrency) : iopool_(concurrency) {}
 		~iopool_cp() = default;
 
+		/**
+		 * @function : pin each io thread to a cpu core, the io thread i is pinned to cpus[i % cpus.size()]
+		 * must be called before start. eg: server.cpu_affinity({ 0,1,2,3 }); or server.cpu_affinity({ 2 });
+		 */
+		inline bool cpu_affinity(const std::vector<int> & cpus)
+		{
+			return this->iopool_.cpu_affinity(cpus);
+		}
+
+		/**
+		 * @function : pin the io threads to the cpu cores of the numa node, must be called before start.
+		 */
+		inline bool numa_affinity(int node)
+		{
+			return this->iopool_.numa_affinity(node);
+		}
+
+		/**
+		 * @function : get the cpu core which the io thread of the index is pinned to, -1 means not pinned
+		 * or the pinning is failed (eg: the cpu is not allowed by the cpuset of the process)
+		 */
+		inline int cpu_of(std::size_t index) const
+		{
+			return this->iopool_.cpu_of(index);
+		}
+
+		/**
+		 * @function : get the io_context pool size
+		 */
+		inline std::size_t iopool_size() const
+		{
+			return this->iopool_.size();
+		}
+
+		/**
+		 * @function : set the policy used to choose the io_context for a new session, the default is round_robin
+		 * eg: server.io_placement(asio2::io_placement::least_sessions);
+		 */
+		inline void io_placement(detail::io_placement policy)
+		{
+			this->iopool_.placement(policy);
+		}
+
+		/**
+		 * @function : get the policy used to choose the io_context for a new session
+		 */
+		inline detail::io_placement io_placement() const
+		{
+			return this->iopool_.placement();
+		}
+
 	protected:
 		/// the io_context pool for socket event
 		iopool iopool_;
 	};
 }
 
+namespace asio2
+{
+	using io_placement = detail::io_placement;
+}
+
 #endif // !__ASIO2_IOPOOL_HPP__
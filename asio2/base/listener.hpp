@@ -45,6 +45,7 @@ namespace asio2::detail
 		init,
 		start,
 		stop,
+		send_pressure,
 		//send,
 		max
 	};
@@ -23,6 +23,7 @@
 #include <string>
 #include <string_view>
 #include <tuple>
+#include <vector>
 #include <unordered_map>
 #include <type_traits>
 
@@ -35,6 +36,7 @@
 #include <asio2/base/detail/object.hpp>
 #include <asio2/base/detail/allocator.hpp>
 #include <asio2/base/detail/util.hpp>
+#include <asio2/base/detail/function_traits.hpp>
 #include <asio2/base/detail/buffer_wrap.hpp>
 
 #include <asio2/base/component/user_data_cp.hpp>
@@ -124,19 +126,33 @@ namespace asio2::detail
 		 * @function : Asynchronous send data for each session
 		 * supporting multi data formats,see asio::buffer(...) in /asio/buffer.hpp
 		 * You can call this function on the communication thread and anywhere,it's multi thread safed.
+		 * The data is persisted only once into a shared immutable buffer, and all the sessions send
+		 * the same buffer, the buffer is released after the last session has sent it.
 		 * PodType * : send("abc");
 		 * PodType (&data)[N] : double m[10]; send(m);
 		 * std::array<PodType, N> : std::array<int,10> m; send(m);
 		 * std::vector<PodType, Allocator> : std::vector<float> m; send(m);
 		 * std::basic_string<Elem, Traits, Allocator> : std::string m; send(m);
+		 * std::vector<asio::const_buffer> , std::array<asio::const_buffer, N> : only the buffer descriptors
+		 * are persisted, the memory which the buffers refer to must remain valid until all the sessions
+		 * have sent it.
 		 */
 		template<class T>
 		inline derived_t & send(T&& data)
 		{
-			this->sessions_.foreach([&data](std::shared_ptr<session_t>& session_ptr)
+			using data_type = std::remove_cv_t<std::remove_reference_t<T>>;
+			if constexpr (is_buffer_able_v<data_type> || asio::is_const_buffer_sequence<data_type>::value)
 			{
-				session_ptr->send(data);
-			});
+				this->derived()._broadcast(this->derived()._shared_persistence(std::forward<T>(data)),
+					[](std::shared_ptr<session_t>&, std::size_t) {}, std::false_type{});
+			}
+			else
+			{
+				this->sessions_.foreach([&data](std::shared_ptr<session_t>& session_ptr)
+				{
+					session_ptr->send(data);
+				});
+			}
 			return this->derived();
 		}
 
@@ -172,14 +188,49 @@ namespace asio2::detail
 		{
 			if (s)
 			{
-				this->sessions_.foreach([s, count](std::shared_ptr<session_t>& session_ptr)
-				{
-					session_ptr->send(s, count);
-				});
+				using value_type = typename std::remove_cv_t<std::remove_reference_t<CharT>>;
+				this->derived()._broadcast(std::make_shared<const std::basic_string<value_type>>(s, count),
+					[](std::shared_ptr<session_t>&, std::size_t) {}, std::false_type{});
 			}
 			return this->derived();
 		}
 
+		/**
+		 * @function : Asynchronous send data for each session, and the callback is called for each
+		 * session after the data is sent to the session.
+		 * The data is persisted only once into a shared immutable buffer, see send(T&& data).
+		 * You can call this function on the communication thread and anywhere,it's multi thread safed.
+		 * Callback signature : void(std::shared_ptr<asio2::xxx_session>& session_ptr, std::size_t bytes_sent)
+		 */
+		template<class T, class Callback>
+		inline typename std::enable_if_t<is_callable_v<Callback> && (
+			is_buffer_able_v<std::remove_cv_t<std::remove_reference_t<T>>> ||
+			asio::is_const_buffer_sequence<std::remove_cv_t<std::remove_reference_t<T>>>::value), derived_t&>
+			send(T&& data, Callback&& fn)
+		{
+			this->derived()._broadcast(this->derived()._shared_persistence(std::forward<T>(data)),
+				std::forward<Callback>(fn), std::true_type{});
+			return this->derived();
+		}
+
+		/**
+		 * @function : bind send pressure listener
+		 * @param    : fun - a user defined callback function
+		 * @param    : obj - a pointer or reference to a class object, this parameter can be none
+		 * if fun is nonmember function, the obj param must be none, otherwise the obj must be the
+		 * the class object's pointer or refrence.
+		 * This notification is called when the send queue of a session reaches the high watermark (high is true)
+		 * and when it falls to the low watermark again (high is false), see send_watermark.
+		 * Function signature : void(std::shared_ptr<asio2::tcp_session>& session_ptr, bool high)
+		 */
+		template<class F, class ...C>
+		inline derived_t & bind_send_pressure(F&& fun, C&&... obj)
+		{
+			this->listener_.bind(event::send_pressure,
+				observer_t<std::shared_ptr<session_t>&, bool>(std::forward<F>(fun), std::forward<C>(obj)...));
+			return (this->derived());
+		}
+
 	public:
 		/**
 		 * @function : get the acceptor refrence,derived classes must override this function
@@ -247,6 +298,109 @@ namespace asio2::detail
 		 */
 		inline io_t & io() { return this->io_; }
 
+	protected:
+		/**
+		 * persist the broadcast data only once, the result is shared by all the sessions.
+		 */
+		template<class T>
+		inline auto _shared_persistence(T&& data)
+		{
+			using data_type = std::remove_cv_t<std::remove_reference_t<T>>;
+			if constexpr (is_string_view_v<data_type>)
+			{
+				using value_type = typename data_type::value_type;
+				return std::make_shared<const std::basic_string<value_type>>(data.data(), data.size());
+			}
+			else if constexpr (std::is_move_assignable_v<data_type>)
+			{
+				return std::make_shared<const data_type>(std::forward<T>(data));
+			}
+			else
+			{
+				auto buffer = asio::buffer(data);
+				return std::make_shared<const std::string>(reinterpret_cast<const std::string::value_type*>(
+					const_cast<const void*>(buffer.data())), buffer.size());
+			}
+		}
+
+		/**
+		 * send the shared data to all the sessions, the sessions is copied out of the session map
+		 * first, so the session map's lock is not held while the data is queued into the sessions.
+		 */
+		template<class SharedData, class Callback, bool HasCallback>
+		inline void _broadcast(SharedData data, Callback&& fn, std::integral_constant<bool, HasCallback>)
+		{
+			std::vector<std::shared_ptr<session_t>> sessions;
+			sessions.reserve(this->sessions_.size());
+			this->sessions_.foreach([&sessions](std::shared_ptr<session_t>& session_ptr)
+			{
+				sessions.emplace_back(session_ptr);
+			});
+
+			if (sessions.empty())
+				return;
+
+			// every session sends a buffer view of the shared data, and the callback holds the shared
+			// data, so the data is alive until the last session has sent it. a buffer sequence is passed
+			// to the sessions as a whole, asio::buffer(seq) would send the bytes of the buffer descriptors.
+			decltype(auto) buffer = to_buffers(*data);
+
+			if constexpr (HasCallback)
+			{
+				auto f = std::make_shared<std::remove_cv_t<std::remove_reference_t<Callback>>>(
+					std::forward<Callback>(fn));
+				for (std::shared_ptr<session_t>& session_ptr : sessions)
+				{
+					session_ptr->send(buffer, [data, f, s = session_ptr.get()](std::size_t bytes_sent)
+					{
+						std::shared_ptr<session_t> session_ptr = s->shared_from_this();
+						(*f)(session_ptr, bytes_sent);
+					});
+				}
+			}
+			else
+			{
+				std::ignore = fn;
+				for (std::shared_ptr<session_t>& session_ptr : sessions)
+				{
+					session_ptr->send(buffer, [data]() {});
+				}
+			}
+		}
+
+		static constexpr bool _reuse_port_supported()
+		{
+		#if defined(__linux__) && defined(SO_REUSEPORT)
+			return true;
+		#else
+			return false;
+		#endif
+		}
+
+		template<class Socket>
+		inline void _set_reuse_port(Socket & socket)
+		{
+		#if defined(__linux__) && defined(SO_REUSEPORT)
+			socket.set_option(asio::detail::socket_option::boolean<SOL_SOCKET, SO_REUSEPORT>(true));
+		#else
+			std::ignore = socket;
+		#endif
+		}
+
+		/**
+		 * in the reuse port mode the sessions are started in the other io threads, while the counter
+		 * is released in the acceptor io thread, so the counter must be accessed atomically.
+		 */
+		inline std::shared_ptr<void> _load_counter()
+		{
+			return std::atomic_load(&(this->counter_ptr_));
+		}
+
+		inline void _release_counter()
+		{
+			std::atomic_store(&(this->counter_ptr_), std::shared_ptr<void>{});
+		}
+
 	protected:
 		inline session_mgr_t<session_t> & sessions() { return this->sessions_; }
 		inline listener_t               & listener() { return this->listener_; }
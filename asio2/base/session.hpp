@@ -34,6 +34,7 @@
 #include <asio2/base/error.hpp>
 #include <asio2/base/listener.hpp>
 #include <asio2/base/session_mgr.hpp>
+#include <asio2/base/session_pool.hpp>
 
 #include <asio2/base/detail/object.hpp>
 #include <asio2/base/detail/allocator.hpp>
@@ -74,6 +75,7 @@ namespace asio2::detail
 		template <class>               friend class event_queue_cp;
 		template <class, bool>         friend class send_cp;
 		template <class>               friend class post_cp;
+		template <class>               friend class session_pool_t;
 
 	public:
 		using self = session_impl_t<derived_t, socket_t, buffer_t>;
@@ -109,6 +111,7 @@ namespace asio2::detail
 			, io_(rwio)
 			, buffer_(init_buffer_size, max_buffer_size)
 		{
+			this->io_.sessions_.fetch_add(1, std::memory_order_relaxed);
 		}
 
 		/**
@@ -116,6 +119,9 @@ namespace asio2::detail
 		 */
 		~session_impl_t()
 		{
+			// the recycled session is not counted on the io
+			if (!this->recycled_)
+				this->io_.sessions_.fetch_sub(1, std::memory_order_relaxed);
 		}
 
 	protected:
@@ -196,6 +202,45 @@ namespace asio2::detail
 		inline std::atomic<state_t>     & state()    { return this->state_;    }
 		inline std::shared_ptr<derived_t> selfptr()  { return this->derived().shared_from_this(); }
 
+		inline void _fire_send_pressure(std::shared_ptr<derived_t>& this_ptr, bool high)
+		{
+			this->listener_.notify(event::send_pressure, this_ptr, std::move(high));
+		}
+
+		/**
+		 * the session is released and put into the session pool, reset the state which belongs
+		 * to the last connection. the session is not used by any other thread when it's called.
+		 */
+		inline void _recycle()
+		{
+			error_code ec;
+			this->socket_.lowest_layer().close(ec);
+
+			// keep the capacity of the buffer
+			this->buffer_.consume(this->buffer_.size());
+
+			this->_clear_events();
+			this->send_watermark(0, 0);
+			this->send_queue_policy(send_policy::notify);
+
+			this->user_data_.reset();
+			this->counter_ptr_.reset();
+			this->in_sessions = false;
+
+			this->io_.sessions_.fetch_sub(1, std::memory_order_relaxed);
+			this->recycled_ = true;
+		}
+
+		/**
+		 * the session is taken from the session pool for a new connection
+		 */
+		inline void _reuse()
+		{
+			ASIO2_ASSERT(this->state_ == state_t::stopped);
+			this->io_.sessions_.fetch_add(1, std::memory_order_relaxed);
+			this->recycled_ = false;
+		}
+
 	protected:
 		/// asio::strand ,used to ensure socket multi thread safe,we must ensure that only one operator
 		/// can operate the same socket at the same time,and strand can enuser that the event will
@@ -223,6 +268,9 @@ namespace asio2::detail
 
 		/// use this to ensure that server stop only after all sessions are closed
 		std::shared_ptr<void>       counter_ptr_;
+
+		/// whether the session is kept by the session pool
+		bool                        recycled_ = false;
 	};
 }
 
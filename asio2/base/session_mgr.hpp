@@ -15,10 +15,15 @@
 #pragma once
 #endif // defined(_MSC_VER) && (_MSC_VER >= 1200)
 
+#include <cstdint>
 #include <algorithm>
+#include <atomic>
+#include <thread>
+#include <unordered_map>
 #include <mutex>
 #include <shared_mutex>
 #include <memory>
+#include <vector>
 #include <functional>
 #include <type_traits>
 
@@ -31,6 +36,12 @@ namespace asio2::detail
 {
 	/**
 	 * the session manager interface
+	 * The sessions are spread over several shards by the hash of the session key, every shard
+	 * has its own map and rwlock, so the lookups (eg: udp dispatch) and the traversals (eg: 
+	 * broadcast) of different shards never contend with each other.
+	 * The emplace and erase are still serialized by the acceptor strand, so the callbacks of
+	 * them are always called in the acceptor io thread with the same order as before, unless
+	 * the serialization is disabled by the server which accepts the sessions in multi threads.
 	 */
 	template<class session_t>
 	class session_mgr_t
@@ -39,12 +50,140 @@ namespace asio2::detail
 		using self = session_mgr_t<session_t>;
 		using key_type = typename session_t::key_type;
 
+		/// the max shard count, the shards of the constructor is limited to it
+		static constexpr std::size_t max_shards = 256;
+
+	protected:
+
+		struct alignas(64) shard
+		{
+			/// session unorder map,these session is already connected session 
+			std::unordered_map<key_type, std::shared_ptr<session_t>> sessions_;
+
+			/// use rwlock to make this shard thread safe
+			std::shared_mutex mutex_;
+
+			/// increased when a session is erased from this shard, the lookup caches compare it to
+			/// find out the stale entries
+			std::atomic<std::uint64_t> version_{ 0 };
+		};
+
+	public:
+		/**
+		 * a small direct mapped cache in front of the shards for the hot lookup path (eg: the udp
+		 * dispatch), a hit costs a key compare, a relaxed atomic load and a weak_ptr lock, no lock of
+		 * the shard. An entry is valid only when the version of its shard is not changed since it was
+		 * filled, so a session erased from the manager is never returned by the cache, and the cache
+		 * holds weak refrences, so it doesn't keep the erased sessions alive.
+		 * The cache is not thread safe, each thread (eg: each receiving socket) must own one.
+		 */
+		class lookup_cache
+		{
+		public:
+			/**
+			 * @constructor
+			 * @param    : count - the entry count, will be rounded up to a power of 2
+			 */
+			explicit lookup_cache(session_mgr_t & mgr, std::size_t count = 64) : mgr_(mgr)
+			{
+				std::size_t n = 1;
+				while (n < count)
+					n <<= 1;
+
+				this->entries_.resize(n);
+				this->mask_ = n - 1;
+			}
+
+			/**
+			 * @destructor
+			 */
+			~lookup_cache() = default;
+
+			lookup_cache(const lookup_cache&) = delete;
+			lookup_cache& operator=(const lookup_cache&) = delete;
+
+			/**
+			 * @function : find the session by map key, return empty if the session is not found.
+			 */
+			inline std::shared_ptr<session_t> find(const key_type & key)
+			{
+				std::size_t h = std::hash<key_type>()(key);
+				shard & s = this->mgr_._shard_of_hash(h);
+				entry & e = this->entries_[self::_mix(h) & this->mask_];
+
+				if (e.shard_ == &s && e.version_ == s.version_.load(std::memory_order_acquire) && e.key_ == key)
+				{
+					if (std::shared_ptr<session_t> session_ptr = e.session_.lock(); session_ptr)
+						return session_ptr;
+				}
+
+				std::shared_lock<std::shared_mutex> guard(s.mutex_);
+				auto iter = s.sessions_.find(key);
+				if (iter == s.sessions_.end())
+				{
+					e.session_.reset();
+					e.shard_ = nullptr;
+					return std::shared_ptr<session_t>();
+				}
+
+				e.key_ = key;
+				e.session_ = iter->second;
+				e.shard_ = &s;
+				e.version_ = s.version_.load(std::memory_order_relaxed);
+
+				return iter->second;
+			}
+
+			/**
+			 * @function : clear all the entries
+			 */
+			inline void clear()
+			{
+				for (entry & e : this->entries_)
+				{
+					e.session_.reset();
+					e.shard_ = nullptr;
+				}
+			}
+
+		protected:
+			struct entry
+			{
+				key_type                   key_{};
+				std::weak_ptr<session_t>   session_;
+				shard                    * shard_ = nullptr;
+				std::uint64_t              version_ = 0;
+			};
+
+			session_mgr_t      & mgr_;
+
+			std::vector<entry>   entries_;
+
+			std::size_t          mask_ = 0;
+		};
+
+	public:
 		/**
 		 * @constructor
+		 * @param    : shards - the shard count, will be rounded up to a power of 2
 		 */
-		explicit session_mgr_t(io_t & acceptor_io) : io_(acceptor_io)
+		explicit session_mgr_t(io_t & acceptor_io, std::size_t shards = 0)
+			: io_(acceptor_io)
 		{
-			this->sessions_.reserve(64);
+			if (shards == 0)
+				shards = std::thread::hardware_concurrency() * 2;
+
+			std::size_t count = 1;
+			while (count < shards && count < max_shards)
+				count <<= 1;
+
+			this->shards_ = std::make_unique<shard[]>(count);
+			this->mask_ = count - 1;
+
+			for (std::size_t i = 0; i < count; ++i)
+			{
+				this->shards_[i].sessions_.reserve(64 / count + 1);
+			}
 		}
 
 		/**
@@ -60,18 +199,22 @@ namespace asio2::detail
 			if (!session_ptr)
 				return;
 
-			if (!this->io_.strand().running_in_this_thread())
+			if (this->serialize_ && !this->io_.strand().running_in_this_thread())
 				return asio::post(this->io_.strand(), make_allocator(this->allocator_,
 					std::bind(&self::emplace, this, std::move(session_ptr), std::move(callback))));
 
 			bool inserted = false;
 
 			{
-				std::unique_lock<std::shared_mutex> guard(this->mutex_);
-				inserted = this->sessions_.try_emplace(session_ptr->hash_key(), session_ptr).second;
+				shard & s = this->_shard(session_ptr->hash_key());
+				std::unique_lock<std::shared_mutex> guard(s.mutex_);
+				inserted = s.sessions_.try_emplace(session_ptr->hash_key(), session_ptr).second;
 				session_ptr->in_sessions = inserted;
 			}
 
+			if (inserted)
+				this->size_.fetch_add(1, std::memory_order_relaxed);
+
 			(callback)(inserted);
 		}
 
@@ -83,18 +226,24 @@ namespace asio2::detail
 			if (!session_ptr)
 				return;
 
-			if (!this->io_.strand().running_in_this_thread())
+			if (this->serialize_ && !this->io_.strand().running_in_this_thread())
 				return asio::post(this->io_.strand(), make_allocator(this->allocator_,
 					std::bind(&self::erase, this, std::move(session_ptr), std::move(callback))));
 
 			bool erased = false;
 
 			{
-				std::unique_lock<std::shared_mutex> guard(this->mutex_);
+				shard & s = this->_shard(session_ptr->hash_key());
+				std::unique_lock<std::shared_mutex> guard(s.mutex_);
 				if (session_ptr->in_sessions)
-					erased = (this->sessions_.erase(session_ptr->hash_key()) > 0);
+					erased = (s.sessions_.erase(session_ptr->hash_key()) > 0);
+				if (erased)
+					s.version_.fetch_add(1, std::memory_order_release);
 			}
 
+			if (erased)
+				this->size_.fetch_sub(1, std::memory_order_relaxed);
+
 			(callback)(erased);
 		}
 
@@ -113,11 +262,15 @@ namespace asio2::detail
 		 */
 		inline void foreach(const std::function<void(std::shared_ptr<session_t> &)> & fn)
 		{
-			std::shared_lock<std::shared_mutex> guard(this->mutex_);
-			for (auto &[k, session_ptr] : this->sessions_)
+			for (std::size_t i = 0; i <= this->mask_; ++i)
 			{
-				std::ignore = k;
-				fn(session_ptr);
+				shard & s = this->shards_[i];
+				std::shared_lock<std::shared_mutex> guard(s.mutex_);
+				for (auto &[k, session_ptr] : s.sessions_)
+				{
+					std::ignore = k;
+					fn(session_ptr);
+				}
 			}
 		}
 
@@ -126,9 +279,10 @@ namespace asio2::detail
 		 */
 		inline std::shared_ptr<session_t> find(const key_type & key)
 		{
-			std::shared_lock<std::shared_mutex> guard(this->mutex_);
-			auto iter = this->sessions_.find(key);
-			return (iter == this->sessions_.end() ? std::shared_ptr<session_t>() : iter->second);
+			shard & s = this->_shard(key);
+			std::shared_lock<std::shared_mutex> guard(s.mutex_);
+			auto iter = s.sessions_.find(key);
+			return (iter == s.sessions_.end() ? std::shared_ptr<session_t>() : iter->second);
 		}
 
 		/**
@@ -136,13 +290,19 @@ namespace asio2::detail
 		 */
 		inline std::shared_ptr<session_t> find_if(const std::function<bool(std::shared_ptr<session_t> &)> & fn)
 		{
-			std::shared_lock<std::shared_mutex> guard(this->mutex_);
-			auto iter = std::find_if(this->sessions_.begin(), this->sessions_.end(),
-				[this, &fn](auto &pair)
+			for (std::size_t i = 0; i <= this->mask_; ++i)
 			{
-				return fn(pair.second);
-			});
-			return (iter == this->sessions_.end() ? std::shared_ptr<session_t>() : iter->second);
+				shard & s = this->shards_[i];
+				std::shared_lock<std::shared_mutex> guard(s.mutex_);
+				auto iter = std::find_if(s.sessions_.begin(), s.sessions_.end(),
+					[&fn](auto &pair)
+				{
+					return fn(pair.second);
+				});
+				if (iter != s.sessions_.end())
+					return iter->second;
+			}
+			return std::shared_ptr<session_t>();
 		}
 
 		/**
@@ -150,7 +310,7 @@ namespace asio2::detail
 		 */
 		inline std::size_t size()
 		{
-			return this->sessions_.size();
+			return this->size_.load(std::memory_order_relaxed);
 		}
 
 		/**
@@ -158,18 +318,67 @@ namespace asio2::detail
 		 */
 		inline bool empty()
 		{
-			return this->sessions_.empty();
+			return (this->size() == 0);
+		}
+
+		/**
+		 * @function : set whether the emplace and erase are serialized by the acceptor strand, if not,
+		 * they are executed in the calling thread and the callbacks are called in the calling thread.
+		 * it's only safe when the emplace and erase of the same session key are always called in the
+		 * same thread, eg : the udp server with a socket for each io.
+		 */
+		inline void serialize(bool enable)
+		{
+			this->serialize_ = enable;
+		}
+
+		/**
+		 * @function : get the shard count
+		 */
+		inline std::size_t shard_count() const
+		{
+			return (this->mask_ + 1);
+		}
+
+	protected:
+		/**
+		 * the tcp session key is the session address which low bits are always zero,
+		 * so mix the hash value to spread the sessions over all the shards.
+		 */
+		inline shard & _shard(const key_type & key)
+		{
+			return this->_shard_of_hash(std::hash<key_type>()(key));
+		}
+
+		inline shard & _shard_of_hash(std::size_t h)
+		{
+			return this->shards_[self::_mix(h) & this->mask_];
+		}
+
+		static inline std::size_t _mix(std::size_t v)
+		{
+			std::uint64_t h = static_cast<std::uint64_t>(v);
+			h ^= h >> 33;
+			h *= 0xff51afd7ed558ccdull;
+			h ^= h >> 33;
+			return static_cast<std::size_t>(h);
 		}
 
 	protected:
-		/// session unorder map,these session is already connected session 
-		std::unordered_map<key_type, std::shared_ptr<session_t>> sessions_;
+		/// the session shards
+		std::unique_ptr<shard[]> shards_;
 
-		/// use rwlock to make this session map thread safe
-		std::shared_mutex mutex_;
+		/// the shard count minus one, the shard count is always a power of 2
+		std::size_t mask_ = 0;
+
+		/// the total session count of all shards
+		std::atomic<std::size_t> size_{ 0 };
 
 		io_t & io_;
 
+		/// whether the emplace and erase are serialized by the acceptor strand
+		bool serialize_ = true;
+
 		/// The memory to use for handler-based custom memory allocation.
 		handler_memory<size_op<>, std::true_type> allocator_;
 	};
@@ -0,0 +1,214 @@
+/*
+ * COPYRIGHT (C) 2017-2019, zhllxt
+ *
+ * author   : zhllxt
+ * email    : 37792738@qq.com
+ *
+ * Distributed under the GNU GENERAL PUBLIC LICENSE Version 3, 29 June 2007
+ * (See accompanying file LICENSE or see <http://www.gnu.org/licenses/>)
+ */
+
+#ifndef __ASIO2_SESSION_POOL_HPP__
+#define __ASIO2_SESSION_POOL_HPP__
+
+#if defined(_MSC_VER) && (_MSC_VER >= 1200)
+#pragma once
+#endif // defined(_MSC_VER) && (_MSC_VER >= 1200)
+
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <vector>
+#include <type_traits>
+#include <unordered_map>
+
+#include <asio2/base/iopool.hpp>
+
+namespace asio2::detail
+{
+	/**
+	 * the counters of the session pool, the reuse rate is : reused / (created + reused)
+	 * created  : the sessions which are created by new
+	 * reused   : the sessions which are taken from the pool
+	 * recycled : the released sessions which are put into the pool
+	 * dropped  : the released sessions which are deleted, because the pool is full or closed
+	 */
+	struct session_pool_stats
+	{
+		std::size_t created  = 0;
+		std::size_t reused   = 0;
+		std::size_t recycled = 0;
+		std::size_t dropped  = 0;
+	};
+
+	/**
+	 * whether the session can be recycled by the session pool, the session must reset all of its per
+	 * connection state in _recycle, and its socket must be able to be reopened after closed. so the
+	 * ssl, http, websocket and rpc sessions are not poolable.
+	 */
+	template<class session_t>
+	struct is_poolable_session : std::false_type {};
+
+	/**
+	 * keep the released sessions and reuse them for the new connections, the sessions are kept
+	 * for each io_t, because the socket and timers of a session are bound to its io_context.
+	 */
+	template<class session_t>
+	class session_pool_t : public std::enable_shared_from_this<session_pool_t<session_t>>
+	{
+	public:
+		/**
+		 * @constructor
+		 */
+		explicit session_pool_t(std::size_t max_count) : max_count_(max_count) {}
+
+		/**
+		 * @destructor
+		 */
+		~session_pool_t()
+		{
+			this->close();
+		}
+
+		/**
+		 * @function : take a recycled session which belongs to the io, or create a new one by the
+		 * creator if there is none. the returned shared_ptr gives the session back to the pool when
+		 * it's released.
+		 * Creator signature : session_t*()
+		 */
+		template<class Creator>
+		inline std::shared_ptr<session_t> acquire(io_t & io, Creator&& creator)
+		{
+			session_t * p = nullptr;
+			{
+				std::lock_guard<std::mutex> guard(this->mutex_);
+				auto it = this->sessions_.find(&io);
+				if (it != this->sessions_.end() && !it->second.empty())
+				{
+					p = it->second.back();
+					it->second.pop_back();
+					--(this->count_);
+					++(this->stats_.reused);
+				}
+			}
+
+			if (p)
+			{
+				p->_reuse();
+			}
+			else
+			{
+				p = creator();
+				std::lock_guard<std::mutex> guard(this->mutex_);
+				++(this->stats_.created);
+			}
+
+			return std::shared_ptr<session_t>(p, [pool = this->shared_from_this()](session_t * p)
+			{
+				pool->_recycle(p);
+			});
+		}
+
+		/**
+		 * @function : allow the released sessions to be recycled
+		 */
+		inline void open()
+		{
+			std::lock_guard<std::mutex> guard(this->mutex_);
+			this->closed_ = false;
+		}
+
+		/**
+		 * @function : delete all the recycled sessions, and the sessions which are released later
+		 * are deleted directly until open is called.
+		 */
+		inline void close()
+		{
+			std::unordered_map<io_t*, std::vector<session_t*>> sessions;
+			{
+				std::lock_guard<std::mutex> guard(this->mutex_);
+				this->closed_ = true;
+				this->count_ = 0;
+				sessions.swap(this->sessions_);
+			}
+			for (auto & [io, v] : sessions)
+			{
+				std::ignore = io;
+				for (session_t * p : v)
+					delete p;
+			}
+		}
+
+		/**
+		 * @function : get the counters of the pool
+		 */
+		inline session_pool_stats stats()
+		{
+			std::lock_guard<std::mutex> guard(this->mutex_);
+			return this->stats_;
+		}
+
+	protected:
+		inline void _recycle(session_t * p)
+		{
+			bool drop = false;
+			{
+				std::lock_guard<std::mutex> guard(this->mutex_);
+				if (this->closed_ || this->count_ >= this->max_count_)
+				{
+					drop = true;
+					++(this->stats_.dropped);
+				}
+				else
+				{
+					// reserve the room before the resetting
+					++(this->count_);
+				}
+			}
+
+			if (drop)
+			{
+				delete p;
+				return;
+			}
+
+			// reset the session outside of the lock, it closes the socket
+			p->_recycle();
+
+			{
+				std::lock_guard<std::mutex> guard(this->mutex_);
+				if (!this->closed_)
+				{
+					this->sessions_[&(p->io())].emplace_back(p);
+					++(this->stats_.recycled);
+					return;
+				}
+				++(this->stats_.dropped);
+			}
+
+			delete p;
+		}
+
+	protected:
+		std::mutex                                          mutex_;
+
+		/// the recycled sessions of each io
+		std::unordered_map<io_t*, std::vector<session_t*>> sessions_;
+
+		/// the number of the recycled sessions
+		std::size_t                                         count_ = 0;
+
+		std::size_t                                         max_count_ = 0;
+
+		bool                                                closed_ = false;
+
+		session_pool_stats                                  stats_;
+	};
+}
+
+namespace asio2
+{
+	using session_pool_stats = detail::session_pool_stats;
+}
+
+#endif // !__ASIO2_SESSION_POOL_HPP__
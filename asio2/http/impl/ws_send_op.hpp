@@ -24,6 +24,7 @@
 
 #include <asio2/base/selector.hpp>
 #include <asio2/base/error.hpp>
+#include <asio2/base/detail/buffer_wrap.hpp>
 
 namespace asio2::detail
 {
@@ -46,7 +47,7 @@ namespace asio2::detail
 		inline bool _ws_send(Data& data, Callback&& callback)
 		{
 #if defined(ASIO2_SEND_CORE_ASYNC)
-			derive.ws_stream().async_write(asio::buffer(data), asio::bind_executor(derive.io().strand(),
+			derive.ws_stream().async_write(to_buffers(data), asio::bind_executor(derive.io().strand(),
 				make_allocator(derive.wallocator(),
 					[this, p = derive.selfptr(), callback = std::forward<Callback>(callback)]
 			(const error_code& ec, std::size_t bytes_sent) mutable
@@ -60,7 +61,7 @@ namespace asio2::detail
 			return true;
 #else
 			error_code ec;
-			std::size_t bytes_sent = derive.ws_stream().write(asio::buffer(data), ec);
+			std::size_t bytes_sent = derive.ws_stream().write(to_buffers(data), ec);
 			set_last_error(ec);
 			callback(ec, bytes_sent);
 			return (!bool(ec));
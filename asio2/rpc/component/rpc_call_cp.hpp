@@ -52,7 +52,8 @@ auto f(Args&& ... args){
 #include <tuple>
 #include <unordered_map>
 #include <type_traits>
-#include <map>
+#include <algorithm>
+#include <limits>
 
 #include <asio2/base/selector.hpp>
 #include <asio2/base/error.hpp>
@@ -60,12 +61,15 @@ auto f(Args&& ... args){
 #include <asio2/rpc/detail/serialization.hpp>
 #include <asio2/rpc/detail/protocol.hpp>
 #include <asio2/rpc/detail/invoker.hpp>
+#include <asio2/rpc/detail/rpc_pending.hpp>
 
 namespace asio2::detail
 {
 	template<class derived_t, bool isSession>
 	class rpc_call_cp
 	{
+		template <class, class> friend class rpc_pending_op;
+
 	public:
 		/**
 		 * @constructor
@@ -78,7 +82,12 @@ namespace asio2::detail
 		/**
 		 * @destructor
 		 */
-		~rpc_call_cp() = default;
+		~rpc_call_cp()
+		{
+			// the nodes must be unlinked from the timer wheel before destroyed
+			for (auto & node : this->pending_.release())
+				this->wio_.wheel().cancel(*node);
+		}
 
 	public:
 		/**
@@ -180,7 +189,142 @@ namespace asio2::detail
 			derive.template _do_async_call<T>(std::forward<Callback>(fn), timeout, std::move(name), std::forward<Args>(args)...);
 		}
 
+#if defined(ASIO2_RPC_COROUTINE)
+		/**
+		 * @function : call a rpc function in a coroutine, use like this :
+		 * int v = co_await client.co_call<int>("add", 1, 2);
+		 * the request is sent immediately, the coroutine is resumed in the io thread when the
+		 * response is received or timed out, throw system_error if failed.
+		 * You must guarantee that the parameter args remain valid until the send operation is called.
+		 */
+		template<class T, class ...Args>
+		inline rpc_awaitable<T> co_call(std::string name, Args&&... args)
+		{
+			return derive.template _do_co_call<T>(nullptr, derive.timeout(), std::move(name), std::forward<Args>(args)...);
+		}
+
+		/**
+		 * @function : call a rpc function in a coroutine, throw system_error if failed.
+		 */
+		template<class T, class Rep, class Period, class ...Args>
+		inline rpc_awaitable<T> co_call(std::chrono::duration<Rep, Period> timeout, std::string name, Args&&... args)
+		{
+			return derive.template _do_co_call<T>(nullptr, timeout, std::move(name), std::forward<Args>(args)...);
+		}
+
+		/**
+		 * @function : call a rpc function in a coroutine, the error is stored in the ec, the ec must
+		 * remain valid until the co_await is finished.
+		 */
+		template<class T, class ...Args>
+		inline rpc_awaitable<T> co_call(error_code& ec, std::string name, Args&&... args)
+		{
+			return derive.template _do_co_call<T>(&ec, derive.timeout(), std::move(name), std::forward<Args>(args)...);
+		}
+
+		/**
+		 * @function : call a rpc function in a coroutine, the error is stored in the ec, the ec must
+		 * remain valid until the co_await is finished.
+		 */
+		template<class T, class Rep, class Period, class ...Args>
+		inline rpc_awaitable<T> co_call(error_code& ec, std::chrono::duration<Rep, Period> timeout,
+			std::string name, Args&&... args)
+		{
+			return derive.template _do_co_call<T>(&ec, timeout, std::move(name), std::forward<Args>(args)...);
+		}
+#endif
+
 	protected:
+#if defined(ASIO2_RPC_COROUTINE)
+		template<class T, class Rep, class Period, class ...Args>
+		inline rpc_awaitable<T> _do_co_call(error_code* ec, std::chrono::duration<Rep, Period> timeout,
+			std::string name, Args&&... args)
+		{
+			rpc_awaitable<T> awaiter(ec);
+			derive.template _do_async_call<T>(awaiter.handler(), timeout, std::move(name), std::forward<Args>(args)...);
+			return awaiter;
+		}
+#endif
+
+		template<class Rep, class Period>
+		static inline std::uint32_t _rpc_timeout_ms(std::chrono::duration<Rep, Period> timeout)
+		{
+			auto ms = std::chrono::duration_cast<std::chrono::milliseconds>(timeout).count();
+			return static_cast<std::uint32_t>((std::clamp)(decltype(ms)(ms), decltype(ms)(1),
+				decltype(ms)((std::numeric_limits<std::uint32_t>::max)())));
+		}
+
+		/**
+		 * add the pending request, it's expired by the timer wheel of the io after timeout milliseconds,
+		 * 0 means no timeout. must be called in the strand.
+		 */
+		template<class Callback>
+		inline void _rpc_emplace(header::id_type id, Callback&& cb, std::uint32_t timeout)
+		{
+			using op_type = rpc_pending_op<rpc_call_cp<derived_t, isSession>, std::decay_t<Callback>>;
+
+			std::unique_ptr<rpc_pending_node> node = std::make_unique<op_type>(*this, id, std::forward<Callback>(cb));
+
+			if (timeout)
+				this->wio_.wheel().schedule(*node, timeout);
+
+			this->pending_.emplace(std::move(node));
+		}
+
+		/**
+		 * remove the pending request without calling it. must be called in the strand.
+		 */
+		inline void _rpc_erase(header::id_type id)
+		{
+			std::unique_ptr<rpc_pending_node> node = this->pending_.erase(id);
+			if (node)
+				this->wio_.wheel().cancel(*node);
+		}
+
+		/**
+		 * remove the pending request and call it, the response is in the dr_ if ec is empty.
+		 * must be called in the strand.
+		 */
+		inline void _rpc_complete(header::id_type id, error_code ec, std::string_view s)
+		{
+			std::unique_ptr<rpc_pending_node> node = this->pending_.erase(id);
+			if (!node)
+				return;
+
+			this->wio_.wheel().cancel(*node);
+
+			node->invoke(ec, s);
+		}
+
+		/**
+		 * call all the pending requests with the ec, when the connection is closed.
+		 */
+		inline void _rpc_complete_all(error_code ec)
+		{
+			for (auto & node : this->pending_.release())
+			{
+				this->wio_.wheel().cancel(*node);
+
+				node->invoke(ec, std::string_view{});
+			}
+		}
+
+		/**
+		 * serialize the request in the compact form if the peer supports it, otherwise in the string
+		 * form with the compact flag, which tells the peer that the compact response is acceptable.
+		 * must be called in the strand, the rpc_compact_ is changed by the recv op.
+		 */
+		template<class Req>
+		inline const std::string& _rpc_serialize(Req& req)
+		{
+			if (this->rpc_compact_)
+				req.type(rpc_type_req_compact);
+			else
+				req.compact(true);
+
+			return (sr_.reset() << req).str();
+		}
+
 		template<class T, class Rep, class Period, class ...Args>
 		inline T _do_call(error_code& ec, std::chrono::duration<Rep, Period> timeout, std::string name, Args&&... args)
 		{
@@ -198,6 +342,8 @@ namespace asio2::detail
 
 				auto cb = [this, v, id, pm = std::move(promise)](error_code ec, std::string_view s) mutable
 				{
+					ignore::unused(s);
+
 					if (!ec)
 					{
 						try
@@ -212,8 +358,6 @@ namespace asio2::detail
 					}
 					set_last_error(ec);
 					pm->set_value(ec);
-
-					this->reqs_.erase(id);
 				};
 
 				// Make sure we run on the strand
@@ -222,9 +366,10 @@ namespace asio2::detail
 					asio::post(this->wio_.strand(), make_allocator(derive.wallocator(),
 						[this, p = derive.selfptr(), req = std::move(req), cb = std::move(cb)]() mutable
 					{
-						if (derive.send((sr_.reset() << req).str()))
+						if (derive.send(this->_rpc_serialize(req)))
 						{
-							this->reqs_.emplace(req.id(), std::move(cb));
+							// the timeout is handled by the waiting thread
+							this->_rpc_emplace(req.id(), std::move(cb), 0);
 						}
 						else
 						{
@@ -242,7 +387,7 @@ namespace asio2::detail
 						asio::post(this->wio_.strand(), make_allocator(derive.wallocator(),
 							[this, p = derive.selfptr(), id]()
 						{
-							this->reqs_.erase(id);
+							this->_rpc_erase(id);
 						}));
 					}
 				}
@@ -257,7 +402,7 @@ namespace asio2::detail
 					//	// Set ec a default value of timed_out first
 					//	ec = asio::error::timed_out;
 					//	std::future_status status = std::future_status::timeout;
-					//	this->reqs_.emplace(req.id(), std::move(cb));
+					//	this->_rpc_emplace(req.id(), std::move(cb), 0);
 					//	auto t1 = std::chrono::steady_clock::now();
 					//	for (auto elapsed = t1 - t1; elapsed < timeout; elapsed = std::chrono::steady_clock::now() - t1)
 					//	{
@@ -270,7 +415,7 @@ namespace asio2::detail
 					//		}
 					//	}
 					//	if (status != std::future_status::ready)
-					//		this->reqs_.erase(req.id());
+					//		this->_rpc_erase(req.id());
 					//}
 					//else
 					//{
@@ -314,29 +459,9 @@ namespace asio2::detail
 
 			header::id_type id = derive.mkid();
 
-			copyable_wrapper<asio::steady_timer> timer(this->wio_.context());
-			timer().expires_after(timeout);
-			timer().async_wait(asio::bind_executor(this->wio_.strand(), [this, id](const error_code & ec)
-			{
-				if (ec == asio::error::operation_aborted)
-					return;
-				auto iter = this->reqs_.find(id);
-				if (iter != this->reqs_.end())
-				{
-					auto& cb = iter->second;
-					cb(asio::error::timed_out, std::string_view{});
-				}
-			}));
-
-			auto cb = [this, id, timer = std::move(timer), fn = std::forward<Callback>(fn)]
-			(error_code ec, std::string_view s) mutable
+			auto cb = [this, fn = std::forward<Callback>(fn)](error_code ec, std::string_view s) mutable
 			{
-				try
-				{
-					timer().cancel();
-				}
-				catch (system_error &) {}
-				catch (std::exception &) {}
+				ignore::unused(s);
 
 				typename result_t<T>::type v{};
 				if (!ec)
@@ -357,8 +482,6 @@ namespace asio2::detail
 					fn(ec);
 				else
 					fn(ec, std::move(v));
-
-				this->reqs_.erase(id);
 			};
 
 			try
@@ -368,11 +491,11 @@ namespace asio2::detail
 
 				request<Args...> req(id, std::move(name), std::forward<Args>(args)...);
 
-				auto task = [this, p = derive.selfptr(), req = std::move(req), cb = std::move(cb)]() mutable
+				auto task = [this, p = derive.selfptr(), req = std::move(req), cb = std::move(cb), timeout]() mutable
 				{
-					if (derive.send((sr_.reset() << req).str()))
+					if (derive.send(this->_rpc_serialize(req)))
 					{
-						this->reqs_.emplace(req.id(), std::move(cb));
+						this->_rpc_emplace(req.id(), std::move(cb), _rpc_timeout_ms(timeout));
 					}
 					else
 					{
@@ -406,7 +529,11 @@ namespace asio2::detail
 		serializer    & sr_;
 		deserializer  & dr_;
 
-		std::map<header::id_type, std::function<void(error_code, std::string_view)>> reqs_;
+		/// the requests which are waiting for the response
+		rpc_pending_table                 pending_;
+
+		/// whether the peer supports the compact form, it's set when the compact response is received
+		bool            rpc_compact_ = false;
 	};
 }
 
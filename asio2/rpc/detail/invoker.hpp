@@ -36,6 +36,7 @@
 #include <asio2/base/detail/function_traits.hpp>
 #include <asio2/rpc/detail/serialization.hpp>
 #include <asio2/rpc/detail/protocol.hpp>
+#include <asio2/rpc/detail/rpc_task.hpp>
 
 namespace asio2::detail
 {
@@ -51,9 +52,13 @@ namespace asio2::detail
 		using type = std::int8_t;
 	};
 
+	template<class, bool> class rpc_recv_op;
+
 	template<typename CallerT>
 	class invoker_t
 	{
+		template <class, bool> friend class rpc_recv_op;
+
 	public:
 		using self = invoker_t<CallerT>;
 
@@ -76,6 +81,10 @@ namespace asio2::detail
 		 * @param    : obj - A pointer or reference to a class object, this parameter can be none
 		 * if fun is nonmember function, the obj param must be none, otherwise the obj must be the
 		 * the class object's pointer or refrence.
+		 * the compact requests find the function by the method id which is the hash of the name, so
+		 * if the method id of the name is the same as the one of another binded name, the function
+		 * is not binded and the last error is set to invalid_argument, the first binding is kept,
+		 * just rename one of them.
 		 */
 		template<class F, class ...C>
 		inline self& bind(std::string const& name, F&& fun, C&&... obj)
@@ -86,8 +95,22 @@ namespace asio2::detail
 				ASIO2_ASSERT(this->invokers_.find(name) == this->invokers_.end());
 			}
 #endif
+			std::uint32_t id = rpc_method_id(name);
+			for (auto & pair : this->invokers_)
+			{
+				// the method id of the name is conflict with another name
+				if (pair.first != name && rpc_method_id(pair.first) == id)
+				{
+					ASIO2_ASSERT(false);
+					set_last_error(asio::error::invalid_argument);
+					return (*this);
+				}
+			}
+
 			this->_bind(name, std::forward<F>(fun), std::forward<C>(obj)...);
 
+			this->_index(rpc_method_id(name));
+
 			return (*this);
 		}
 
@@ -99,6 +122,41 @@ namespace asio2::detail
 			//std::unique_lock<std::shared_mutex> guard(this->mutex_);
 			this->invokers_.erase(name);
 
+			this->_index(rpc_method_id(name));
+
+			return (*this);
+		}
+
+		/**
+		 * @function : execute the rpc functions in the executor instead of the io thread, so a slow
+		 * function doesn't block the other calls of the same connection, the responses are sent in
+		 * the completion order. the executor must be alive until the server or client is stopped.
+		 * @param    : ex - asio2::thread_pool, asio::thread_pool, asio::io_context or an asio executor
+		 * @param    : max_concurrency - the max number of the functions of a connection which are
+		 * executed at the same time, the other requests wait in the queue, 0 means no limit. a
+		 * coroutine function is counted until the coroutine is finished, not until it's suspended.
+		 * it must be called before start.
+		 */
+		template<class Executor>
+		inline self& invoke_executor(Executor& ex, std::size_t max_concurrency = 0)
+		{
+			if constexpr (std::is_convertible_v<Executor&, asio::execution_context&> || asio::is_executor<Executor>::value)
+			{
+				this->executor_ = [&ex](std::function<void()> task)
+				{
+					asio::post(ex, std::move(task));
+				};
+			}
+			else
+			{
+				this->executor_ = [&ex](std::function<void()> task)
+				{
+					ex.post(std::move(task));
+				};
+			}
+
+			this->max_concurrency_ = max_concurrency;
+
 			return (*this);
 		}
 
@@ -114,12 +172,40 @@ namespace asio2::detail
 			return (&(iter->second));
 		}
 
+		/**
+		 * @function : find binded rpc function by method id, the method id is the hash of the name
+		 */
+		inline std::function<void(std::shared_ptr<CallerT>&, serializer&, deserializer&)>* find(std::uint32_t id)
+		{
+			auto iter = this->methods_.find(id);
+			if (iter == this->methods_.end())
+				return nullptr;
+			return iter->second;
+		}
+
 	protected:
 		inline self& _invoker()
 		{
 			return (*this);
 		}
 
+		/**
+		 * rebuild the method id index of the id, the bind makes sure that only one name has the id
+		 */
+		inline void _index(std::uint32_t id)
+		{
+			for (auto & [name, f] : this->invokers_)
+			{
+				if (rpc_method_id(name) == id)
+				{
+					this->methods_[id] = &f;
+					return;
+				}
+			}
+
+			this->methods_.erase(id);
+		}
+
 		template<class F>
 		inline void _bind(std::string const& name, F f)
 		{
@@ -145,7 +231,7 @@ namespace asio2::detail
 		}
 
 		template<class F>
-		inline void _proxy(F f, std::shared_ptr<CallerT>& caller, serializer& sr, deserializer& dr)
+		inline void _proxy(const F& f, std::shared_ptr<CallerT>& caller, serializer& sr, deserializer& dr)
 		{
 			using fun_traits_type = function_traits<F>;
 
@@ -153,7 +239,7 @@ namespace asio2::detail
 		}
 
 		template<class F, class C>
-		inline void _proxy(F f, C* c, std::shared_ptr<CallerT>& caller, serializer& sr, deserializer& dr)
+		inline void _proxy(const F& f, C* c, std::shared_ptr<CallerT>& caller, serializer& sr, deserializer& dr)
 		{
 			using fun_traits_type = function_traits<F>;
 
@@ -162,7 +248,7 @@ namespace asio2::detail
 
 		template<std::size_t Argc, class F>
 		typename std::enable_if_t<Argc == 0>
-			inline _argc_proxy(const F& f, std::shared_ptr<CallerT>&, serializer& sr, deserializer& dr)
+			inline _argc_proxy(const F& f, std::shared_ptr<CallerT>& caller, serializer& sr, deserializer& dr)
 		{
 			using fun_traits_type = function_traits<F>;
 			using fun_args_tuple = typename fun_traits_type::pod_tuple_type;
@@ -170,12 +256,12 @@ namespace asio2::detail
 
 			fun_args_tuple tp;
 			dr >> tp;
-			_invoke<fun_ret_type>(f, sr, dr, tp);
+			_invoke<fun_ret_type>(caller, f, sr, dr, tp);
 		}
 
 		template<std::size_t Argc, class F, class C>
 		typename std::enable_if_t<Argc == 0>
-			inline _argc_proxy(const F& f, C* c, std::shared_ptr<CallerT>&, serializer& sr, deserializer& dr)
+			inline _argc_proxy(const F& f, C* c, std::shared_ptr<CallerT>& caller, serializer& sr, deserializer& dr)
 		{
 			using fun_traits_type = function_traits<F>;
 			using fun_args_tuple = typename fun_traits_type::pod_tuple_type;
@@ -183,7 +269,7 @@ namespace asio2::detail
 
 			fun_args_tuple tp;
 			dr >> tp;
-			_invoke<fun_ret_type>(f, c, sr, dr, tp);
+			_invoke<fun_ret_type>(caller, f, c, sr, dr, tp);
 		}
 
 		template<std::size_t Argc, class F>
@@ -199,13 +285,13 @@ namespace asio2::detail
 			{
 				auto tp = _body_args_tuple((fun_args_tuple*)0);
 				dr >> tp;
-				_invoke<fun_ret_type>(f, sr, dr, std::tuple_cat(std::tuple<std::shared_ptr<CallerT>&>(caller), tp));
+				_invoke<fun_ret_type>(caller, f, sr, dr, std::tuple_cat(std::tuple<std::shared_ptr<CallerT>&>(caller), tp));
 			}
 			else
 			{
 				fun_args_tuple tp;
 				dr >> tp;
-				_invoke<fun_ret_type>(f, sr, dr, tp);
+				_invoke<fun_ret_type>(caller, f, sr, dr, tp);
 			}
 		}
 
@@ -222,13 +308,13 @@ namespace asio2::detail
 			{
 				auto tp = _body_args_tuple((fun_args_tuple*)0);
 				dr >> tp;
-				_invoke<fun_ret_type>(f, c, sr, dr, std::tuple_cat(std::tuple<std::shared_ptr<CallerT>&>(caller), tp));
+				_invoke<fun_ret_type>(caller, f, c, sr, dr, std::tuple_cat(std::tuple<std::shared_ptr<CallerT>&>(caller), tp));
 			}
 			else
 			{
 				fun_args_tuple tp;
 				dr >> tp;
-				_invoke<fun_ret_type>(f, c, sr, dr, tp);
+				_invoke<fun_ret_type>(caller, f, c, sr, dr, tp);
 			}
 		}
 
@@ -245,22 +331,107 @@ namespace asio2::detail
 		}
 
 		template<typename R, typename F, typename... Args>
-		inline void _invoke(const F& f, serializer& sr, deserializer& dr, const std::tuple<Args...>& tp)
+		inline void _invoke(std::shared_ptr<CallerT>& caller, const F& f, serializer& sr, deserializer& dr,
+			const std::tuple<Args...>& tp)
 		{
-			ignore::unused(dr);
+			ignore::unused(caller, dr);
 			typename result_t<R>::type r = _invoke_impl<R>(f, std::make_index_sequence<sizeof...(Args)>{}, tp);
-			sr << error_code{};
-			sr << r;
+#if defined(ASIO2_RPC_COROUTINE)
+			if constexpr (is_rpc_task<R>::value)
+			{
+				_co_invoke<F>(caller, sr, std::move(r));
+				return;
+			}
+			else
+#endif
+			{
+				sr << error_code{};
+				sr << r;
+			}
 		}
 
 		template<typename R, typename F, typename C, typename... Args>
-		inline void _invoke(const F& f, C* c, serializer& sr, deserializer& dr, const std::tuple<Args...>& tp)
+		inline void _invoke(std::shared_ptr<CallerT>& caller, const F& f, C* c, serializer& sr, deserializer& dr,
+			const std::tuple<Args...>& tp)
 		{
-			ignore::unused(dr);
+			ignore::unused(caller, dr);
 			typename result_t<R>::type r = _invoke_impl<R>(f, c, std::make_index_sequence<sizeof...(Args)>{}, tp);
-			sr << error_code{};
-			sr << r;
+#if defined(ASIO2_RPC_COROUTINE)
+			if constexpr (is_rpc_task<R>::value)
+			{
+				_co_invoke<F>(caller, sr, std::move(r));
+				return;
+			}
+			else
+#endif
+			{
+				sr << error_code{};
+				sr << r;
+			}
+		}
+
+#if defined(ASIO2_RPC_COROUTINE)
+		template<typename F, std::size_t... I>
+		static constexpr bool _is_value_args(std::index_sequence<I...>)
+		{
+			return (!std::is_reference_v<typename function_traits<F>::template args<I>::type> && ...);
+		}
+
+		/**
+		 * start the coroutine function, the response is sent when the coroutine is finished. the
+		 * header of the response is written into the sr already, it's kept as the prefix of the
+		 * response, and the sr is cleared to tell the recv op that the response is deferred.
+		 */
+		template<typename F, typename T>
+		inline void _co_invoke(std::shared_ptr<CallerT>& caller, serializer& sr, rpc_task<T> task)
+		{
+			static_assert(_is_value_args<F>(std::make_index_sequence<function_traits<F>::argc>{}),
+				"The parameters of the coroutine rpc function must be passed by value, "
+				"they are used after the coroutine is suspended.");
+
+			std::string prefix = sr.str();
+
+			sr.buffer().clear();
+
+			// the invoker of the client is the client itself, and the selfptr of the client is empty,
+			// the invoker of the sessions is owned by the server, the caller is the session. the
+			// caller is held only to keep the session alive until the coroutine is finished.
+			CallerT * derive = nullptr;
+			if constexpr (std::is_base_of_v<self, CallerT>)
+				derive = static_cast<CallerT*>(this);
+			else
+				derive = caller.get();
+
+			task.start([caller, derive, prefix = std::move(prefix)](std::exception_ptr ex, auto&&... r) mutable
+			{
+				// the coroutine may be resumed in any thread, so don't use the serializer of the caller
+				thread_local serializer out;
+
+				out.buffer().assign(prefix);
+
+				try
+				{
+					if (ex)
+						std::rethrow_exception(ex);
+
+					out << error_code{};
+
+					if constexpr (std::is_void_v<T>)
+						out << typename result_t<T>::type{ 1 };
+					else
+						((out << *r), ...);
+				}
+				catch (cereal::exception&) { out << error_code{ asio::error::no_data }; }
+				catch (system_error& e) { out << e.code(); }
+				catch (std::exception&) { out << error_code{ asio::error::eof }; }
+
+				derive->send(out.str());
+
+				// the request of the executor is finished when the coroutine is finished
+				derive->_rpc_invoke_done(caller);
+			});
 		}
+#endif
 
 		template<typename R, typename F, size_t... I, typename... Args>
 		typename std::enable_if_t<!std::is_same_v<R, void>, typename result_t<R>::type>
@@ -296,6 +467,14 @@ namespace asio2::detail
 		//std::shared_mutex                           mutex_;
 
 		std::unordered_map<std::string, std::function<void(std::shared_ptr<CallerT>&, serializer&, deserializer&)>> invokers_;
+
+		/// the rpc functions are executed in the io thread if it's empty
+		std::function<void(std::function<void()>)>   executor_;
+
+		std::size_t                                  max_concurrency_ = 0;
+
+		/// method id to the function of invokers_, the node of the unordered_map is stable
+		std::unordered_map<std::uint32_t, std::function<void(std::shared_ptr<CallerT>&, serializer&, deserializer&)>*> methods_;
 	};
 }
 
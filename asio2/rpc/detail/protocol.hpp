@@ -17,6 +17,9 @@
 
 #include <string>
 #include <string_view>
+#include <type_traits>
+
+#include <asio2/base/detail/util.hpp>
 
 #include <asio2/rpc/detail/serialization.hpp>
 
@@ -26,32 +29,58 @@ namespace asio2::detail
 	 * request  : message type + request id + function name + parameters value...
 	 * response : message type + request id + function name + error code + result value
 	 *
-	 * message type : q - request, p - response
+	 * compact request  : message type + varint request id + method id + parameters value...
+	 * compact response : message type + varint request id + error code + result value
+	 *
+	 * message type : q - request, p - response, Q - compact request, P - compact response
+	 *
+	 * the method id is the fnv1a hash of the function name, so it's known by both sides without
+	 * exchanging. the caller sends the request in the string form with the rpc_id_compact flag in the
+	 * request id at first, the callee which supports the compact form replies with the compact
+	 * response, then the caller sends the compact requests. the old callee echoes the flag back in the
+	 * string form response, so the caller keeps the string form.
 	 *
 	 * if result type is void, then result type will wrapped to std::int8_t
 	 */
 
 	static constexpr char rpc_type_req = 'q';
 	static constexpr char rpc_type_rep = 'p';
+	static constexpr char rpc_type_req_compact = 'Q';
+	static constexpr char rpc_type_rep_compact = 'P';
+
+	/// the flag of the request id in the string form, means the sender supports the compact form
+	static constexpr std::uint64_t rpc_id_compact = std::uint64_t(1) << 63;
+
+	/**
+	 * get the method id of the function name
+	 */
+	inline std::uint32_t rpc_method_id(std::string_view name)
+	{
+		return fnv1a_hash<std::uint32_t>(reinterpret_cast<const unsigned char *>(name.data()),
+			static_cast<std::uint32_t>(name.size()));
+	}
 
 	class header
 	{
 	public:
 		using id_type = std::uint64_t;
+		using method_type = std::uint32_t;
 
 		header() {}
 		header(char type, id_type id, std::string_view name)
 			: type_(type), id_(id), name_(name) {}
 		~header() = default;
 
-		header(const header& r) : type_(r.type_), id_(r.id_), name_(r.name_) {}
-		header(header&& r) : type_(r.type_), id_(r.id_), name_(std::move(r.name_)) {}
+		header(const header& r) : type_(r.type_), id_(r.id_), name_(r.name_), method_(r.method_), compact_(r.compact_) {}
+		header(header&& r) : type_(r.type_), id_(r.id_), name_(std::move(r.name_)), method_(r.method_), compact_(r.compact_) {}
 
 		inline header& operator=(const header& r)
 		{
 			type_ = r.type_;
 			id_ = r.id_;
 			name_ = r.name_;
+			method_ = r.method_;
+			compact_ = r.compact_;
 			return (*this);
 		}
 		inline header& operator=(header&& r)
@@ -59,30 +88,124 @@ namespace asio2::detail
 			type_ = r.type_;
 			id_ = r.id_;
 			name_ = std::move(r.name_);
+			method_ = r.method_;
+			compact_ = r.compact_;
 			return (*this);
 		}
 
 		template <class Archive>
-		inline void serialize(Archive & ar)
+		inline void save(Archive & ar) const
+		{
+			ar(type_);
+			if (this->is_compact())
+			{
+				_save_varint(ar, id_);
+				if (type_ == rpc_type_req_compact)
+					ar(method_);
+			}
+			else
+			{
+				ar(compact_ ? (id_ | rpc_id_compact) : id_, name_);
+			}
+		}
+
+		template <class Archive>
+		inline void load(Archive & ar)
 		{
-			ar(type_, id_, name_);
+			ar(type_);
+			if (this->is_compact())
+			{
+				id_ = _load_varint(ar);
+				if (type_ == rpc_type_req_compact)
+					ar(method_);
+				name_.clear();
+				compact_ = true;
+			}
+			else
+			{
+				ar(id_);
+				// read the name from the receive buffer directly, the name_ keeps its capacity
+				if constexpr (std::is_same_v<Archive, cereal::RPCPortableBinaryInputArchive>)
+				{
+					cereal::size_type size = 0;
+					ar(cereal::make_size_tag(size));
+					name_.assign(ar.loadView(static_cast<std::size_t>(size)));
+				}
+				else
+				{
+					ar(name_);
+				}
+				compact_ = ((id_ & rpc_id_compact) != 0);
+				id_ &= ~rpc_id_compact;
+			}
 		}
 
 		inline const char         type() const { return this->type_; }
 		inline const id_type      id()   const { return this->id_;   }
 		inline const std::string& name() const { return this->name_; }
 
-		inline bool is_request()  { return this->type_ == rpc_type_req; }
-		inline bool is_response() { return this->type_ == rpc_type_rep; }
+		inline method_type        method() const { return this->method_; }
+
+		inline bool is_request()  { return this->type_ == rpc_type_req || this->type_ == rpc_type_req_compact; }
+		inline bool is_response() { return this->type_ == rpc_type_rep || this->type_ == rpc_type_rep_compact; }
+
+		/**
+		 * whether the message is in the compact form
+		 */
+		inline bool is_compact() const
+		{
+			return (this->type_ == rpc_type_req_compact || this->type_ == rpc_type_rep_compact);
+		}
+
+		/**
+		 * whether the sender of the message supports the compact form
+		 */
+		inline bool compact() const { return this->compact_; }
 
 		inline header& type(char type            ) { this->type_ = type; return (*this); }
 		inline header& id  (id_type id           ) { this->id_   = id  ; return (*this); }
 		inline header& name(std::string_view name) { this->name_ = name; return (*this); }
 
+		inline header& method (method_type method) { this->method_  = method ; return (*this); }
+		inline header& compact(bool compact      ) { this->compact_ = compact; return (*this); }
+
+	protected:
+		template <class Archive>
+		static inline void _save_varint(Archive & ar, id_type v)
+		{
+			while (v >= 0x80)
+			{
+				ar(static_cast<std::uint8_t>((v & 0x7f) | 0x80));
+				v >>= 7;
+			}
+			ar(static_cast<std::uint8_t>(v));
+		}
+
+		template <class Archive>
+		static inline id_type _load_varint(Archive & ar)
+		{
+			id_type v = 0;
+			for (unsigned shift = 0; shift < 64; shift += 7)
+			{
+				std::uint8_t b = 0;
+				ar(b);
+				v |= id_type(b & 0x7f) << shift;
+				if (!(b & 0x80))
+					return v;
+			}
+			throw cereal::Exception("rpc header varint overflow");
+		}
+
 	protected:
 		char           type_;
 		id_type        id_ = 0;
 		std::string    name_;
+
+		/// the method id of the compact request
+		method_type    method_ = 0;
+
+		/// whether the sender supports the compact form
+		bool           compact_ = false;
 	};
 
 	template<class ...Args>
@@ -91,7 +214,10 @@ namespace asio2::detail
 	public:
 		request() : header() { this->type_ = rpc_type_req; }
 		request(id_type id, std::string_view name, Args&&... args)
-			: header(rpc_type_req, id, name), tp_(std::forward_as_tuple(std::forward<Args>(args)...)) {}
+			: header(rpc_type_req, id, name), tp_(std::forward_as_tuple(std::forward<Args>(args)...))
+		{
+			this->method_ = rpc_method_id(name);
+		}
 		~request() = default;
 
 		request(const request& r) : header(r), tp_(r.tp_) {}
@@ -110,8 +236,16 @@ namespace asio2::detail
 			return (*this);
 		}
 
+		// the header has the split save/load, so the derived class must split too
 		template <class Archive>
-		void serialize(Archive & ar)
+		void save(Archive & ar) const
+		{
+			ar(cereal::base_class<header>(this));
+			ar(tp_);
+		}
+
+		template <class Archive>
+		void load(Archive & ar)
 		{
 			ar(cereal::base_class<header>(this));
 			ar(tp_);
@@ -150,13 +284,23 @@ namespace asio2::detail
 		}
 
 		template <class Archive>
-		void serialize(Archive & ar)
+		void save(Archive & ar) const
 		{
 			ar(cereal::base_class<header>(this));
 			ar(ec_.value());
 			ar(ret_);
 		}
 
+		template <class Archive>
+		void load(Archive & ar)
+		{
+			ar(cereal::base_class<header>(this));
+			int value = 0;
+			ar(value);
+			ec_.assign(value, ec_.category());
+			ar(ret_);
+		}
+
 	protected:
 		error_code ec_;
 		T ret_;
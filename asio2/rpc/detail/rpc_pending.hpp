@@ -0,0 +1,225 @@
+/*
+ * COPYRIGHT (C) 2017-2019, zhllxt
+ *
+ * author   : zhllxt
+ * email    : 37792738@qq.com
+ *
+ * Distributed under the GNU GENERAL PUBLIC LICENSE Version 3, 29 June 2007
+ * (See accompanying file LICENSE or see <http://www.gnu.org/licenses/>)
+ */
+
+#ifndef __ASIO2_RPC_PENDING_HPP__
+#define __ASIO2_RPC_PENDING_HPP__
+
+#if defined(_MSC_VER) && (_MSC_VER >= 1200)
+#pragma once
+#endif // defined(_MSC_VER) && (_MSC_VER >= 1200)
+
+#include <cstdint>
+#include <memory>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+#include <asio2/base/selector.hpp>
+#include <asio2/base/error.hpp>
+
+#include <asio2/base/detail/timer_wheel.hpp>
+
+namespace asio2::detail
+{
+	/**
+	 * the request which is waiting for the response, it's linked into the timer wheel of the io for
+	 * the timeout, so there is no steady_timer for each call.
+	 */
+	class rpc_pending_node : public timer_wheel_node
+	{
+	public:
+		using id_type = std::uint64_t;
+
+		explicit rpc_pending_node(id_type id) : id_(id) {}
+		virtual ~rpc_pending_node() = default;
+
+		/**
+		 * called once when the response is received, or timed out, or the connection is closed
+		 */
+		virtual void invoke(error_code ec, std::string_view s) = 0;
+
+		inline id_type id() const { return this->id_; }
+
+	protected:
+		id_type id_;
+	};
+
+	/**
+	 * the pending node which calls the callback, and notify the owner when it's timed out
+	 */
+	template<class Owner, class Callback>
+	class rpc_pending_op : public rpc_pending_node
+	{
+	public:
+		rpc_pending_op(Owner& owner, id_type id, Callback&& cb)
+			: rpc_pending_node(id), owner_(owner), cb_(std::move(cb)) {}
+
+		virtual void invoke(error_code ec, std::string_view s) override
+		{
+			this->cb_(ec, s);
+		}
+
+	protected:
+		virtual void on_wheel_timer() override
+		{
+			this->owner_._rpc_complete(this->id_, asio::error::timed_out, std::string_view{});
+		}
+
+	protected:
+		Owner    & owner_;
+
+		Callback   cb_;
+	};
+
+	/**
+	 * the flat hash table of the pending nodes keyed by the request id, open addressing with linear
+	 * probing, the request ids are sequential, so the fibonacci hashing spreads them well.
+	 * It's not thread safe, all the functions must be called in the strand of the io.
+	 */
+	class rpc_pending_table
+	{
+	public:
+		using id_type = rpc_pending_node::id_type;
+
+		rpc_pending_table() = default;
+		~rpc_pending_table() = default;
+
+		rpc_pending_table(const rpc_pending_table&) = delete;
+		rpc_pending_table& operator=(const rpc_pending_table&) = delete;
+
+		inline std::size_t size() const { return this->size_; }
+
+		inline bool empty() const { return (this->size_ == 0); }
+
+		/**
+		 * @function : insert the node, the id of the node must be not exists.
+		 */
+		inline void emplace(std::unique_ptr<rpc_pending_node> node)
+		{
+			// keep the load factor below 1/2
+			if ((this->size_ + 1) * 2 > this->slots_.size())
+				this->_rehash((std::max)(this->slots_.size() * 2, std::size_t(64)));
+
+			std::size_t i = this->_index(node->id());
+			while (this->slots_[i])
+				i = (i + 1) & this->mask_;
+
+			this->slots_[i] = std::move(node);
+			++(this->size_);
+		}
+
+		inline rpc_pending_node* find(id_type id)
+		{
+			if (this->size_ == 0)
+				return nullptr;
+
+			for (std::size_t i = this->_index(id); this->slots_[i]; i = (i + 1) & this->mask_)
+			{
+				if (this->slots_[i]->id() == id)
+					return this->slots_[i].get();
+			}
+
+			return nullptr;
+		}
+
+		/**
+		 * @function : remove the node and return it, return empty if the id is not exists.
+		 */
+		inline std::unique_ptr<rpc_pending_node> erase(id_type id)
+		{
+			if (this->size_ == 0)
+				return nullptr;
+
+			std::size_t i = this->_index(id);
+			for (; this->slots_[i]; i = (i + 1) & this->mask_)
+			{
+				if (this->slots_[i]->id() == id)
+					break;
+			}
+
+			if (!this->slots_[i])
+				return nullptr;
+
+			std::unique_ptr<rpc_pending_node> node = std::move(this->slots_[i]);
+			--(this->size_);
+
+			// backward shift deletion, move the following nodes of the probe sequence to the hole
+			for (std::size_t j = (i + 1) & this->mask_; this->slots_[j]; j = (j + 1) & this->mask_)
+			{
+				std::size_t k = this->_index(this->slots_[j]->id());
+				if (((j - k) & this->mask_) >= ((j - i) & this->mask_))
+				{
+					this->slots_[i] = std::move(this->slots_[j]);
+					i = j;
+				}
+			}
+
+			return node;
+		}
+
+		/**
+		 * @function : remove all the nodes and return them.
+		 */
+		inline std::vector<std::unique_ptr<rpc_pending_node>> release()
+		{
+			std::vector<std::unique_ptr<rpc_pending_node>> nodes;
+			nodes.reserve(this->size_);
+
+			for (auto & slot : this->slots_)
+			{
+				if (slot)
+					nodes.emplace_back(std::move(slot));
+			}
+
+			this->size_ = 0;
+
+			return nodes;
+		}
+
+	protected:
+		inline std::size_t _index(id_type id) const
+		{
+			return static_cast<std::size_t>((id * 0x9E3779B97F4A7C15ull) >> this->shift_) & this->mask_;
+		}
+
+		inline void _rehash(std::size_t capacity)
+		{
+			std::vector<std::unique_ptr<rpc_pending_node>> slots(capacity);
+			std::swap(this->slots_, slots);
+
+			this->mask_ = capacity - 1;
+			this->shift_ = 64;
+			for (std::size_t n = capacity; n > 1; n >>= 1)
+				--(this->shift_);
+
+			for (auto & node : slots)
+			{
+				if (!node)
+					continue;
+
+				std::size_t i = this->_index(node->id());
+				while (this->slots_[i])
+					i = (i + 1) & this->mask_;
+				this->slots_[i] = std::move(node);
+			}
+		}
+
+	protected:
+		std::vector<std::unique_ptr<rpc_pending_node>>   slots_;
+
+		std::size_t                                      size_ = 0;
+
+		std::size_t                                      mask_ = 0;
+
+		unsigned                                         shift_ = 64;
+	};
+}
+
+#endif // !__ASIO2_RPC_PENDING_HPP__
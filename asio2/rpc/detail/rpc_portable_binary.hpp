@@ -31,7 +31,9 @@
 
 #include <cereal/cereal.hpp>
 
-#include <sstream>
+#include <cstring>
+#include <string>
+#include <string_view>
 #include <limits>
 
 namespace cereal
@@ -60,17 +62,15 @@ namespace cereal
 
   // ######################################################################
   //! An output archive designed to save data in a compact binary representation portable over different architectures
-  /*! This archive outputs data to a stream in an extremely compact binary
-      representation with as little extra metadata as possible.
+  /*! This archive appends data to a std::string in an extremely compact binary
+      representation with as little extra metadata as possible. There is no iostream
+      between the archive and the buffer, so a reused buffer is never reallocated once it
+      has grown to the size of the largest message.
 
       This archive will record the endianness of the data as well as the desired in/out endianness
       and assuming that the user takes care of ensuring serialized types are the same size
       across machines, is portable over different architectures.
 
-      When using a binary archive and a file stream, you must use the
-      std::ios::binary format flag to avoid having your data altered
-      inadvertently.
-
       \warning This archive has not been thoroughly tested across different architectures.
                Please report any issues, optimizations, or feature requests at
                <a href="www.github.com/USCiLab/cereal">the project github</a>.
@@ -114,13 +114,13 @@ namespace cereal
           Endianness itsOutputEndianness;
       };
 
-      //! Construct, outputting to the provided stream
-      /*! @param stream The stream to output to. Should be opened with std::ios::binary flag.
+      //! Construct, outputting to the provided buffer
+      /*! @param buffer The buffer to append to, it's owned by the caller.
           @param options The PortableBinary specific options to use.  See the Options struct
                          for the values of default parameters */
-      RPCPortableBinaryOutputArchive(std::ostream & stream, Options const & options = Options::Default()) :
+      RPCPortableBinaryOutputArchive(std::string & buffer, Options const & options = Options::Default()) :
         OutputArchive<RPCPortableBinaryOutputArchive, AllowEmptyClassElision>(this),
-        itsStream(stream),
+        itsBuffer(buffer),
         itsConvertEndianness( rpc_portable_binary_detail::is_little_endian() ^ options.is_little_endian() )
       {
 		options_.itsOutputEndianness = options.itsOutputEndianness;
@@ -134,35 +134,35 @@ namespace cereal
 		return (*this);
       }
 
-      //! Writes size bytes of data to the output stream
+      //! Writes size bytes of data to the output buffer
       template <std::streamsize DataSize> inline
       void saveBinary( const void * data, std::streamsize size )
       {
-        std::streamsize writtenSize = 0;
+        const char * src = reinterpret_cast<const char*>( data );
 
-        if( itsConvertEndianness )
+        if( DataSize > 1 && itsConvertEndianness )
         {
+          std::size_t offset = itsBuffer.size();
+          itsBuffer.resize( offset + static_cast<std::size_t>( size ) );
+          char * dst = itsBuffer.data() + offset;
           for( std::streamsize i = 0; i < size; i += DataSize )
             for( std::streamsize j = 0; j < DataSize; ++j )
-              writtenSize += itsStream.rdbuf()->sputn( reinterpret_cast<const char*>( data ) + DataSize - j - 1 + i, 1 );
+              dst[i + j] = src[i + DataSize - j - 1];
         }
         else
-          writtenSize = itsStream.rdbuf()->sputn( reinterpret_cast<const char*>( data ), size );
-
-        if(writtenSize != size)
-          throw Exception("Failed to write " + std::to_string(size) + " bytes to output stream! Wrote " + std::to_string(writtenSize));
+          itsBuffer.append( src, static_cast<std::size_t>( size ) );
       }
 
     private:
-      std::ostream & itsStream;
+      std::string & itsBuffer;
       const uint8_t itsConvertEndianness; //!< If set to true, we will need to swap bytes upon saving
 	  Options options_;
   };
 
   // ######################################################################
   //! An input archive designed to load data saved using RPCPortableBinaryOutputArchive
-  /*! This archive outputs data to a stream in an extremely compact binary
-      representation with as little extra metadata as possible.
+  /*! This archive reads data from a caller owned memory block which is set by setbuf,
+      the block must be alive until the loading is finished.
 
       This archive will load the endianness of the serialized data and
       if necessary transform it to match that of the local machine.  This comes
@@ -176,10 +176,6 @@ namespace cereal
       The archive will do nothing to ensure types are the same size - that is
       the responsibility of the user.
 
-      When using a binary archive and a file stream, you must use the
-      std::ios::binary format flag to avoid having your data altered
-      inadvertently.
-
       \warning This archive has not been thoroughly tested across different architectures.
                Please report any issues, optimizations, or feature requests at
                <a href="www.github.com/USCiLab/cereal">the project github</a>.
@@ -223,13 +219,11 @@ namespace cereal
           Endianness itsInputEndianness;
       };
 
-      //! Construct, loading from the provided stream
-      /*! @param stream The stream to read from. Should be opened with std::ios::binary flag.
-          @param options The PortableBinary specific options to use.  See the Options struct
+      //! Construct, the memory block to read from is set by setbuf
+      /*! @param options The PortableBinary specific options to use.  See the Options struct
                          for the values of default parameters */
-      RPCPortableBinaryInputArchive(std::istream & stream, Options const & options = Options::Default()) :
+      RPCPortableBinaryInputArchive(Options const & options = Options::Default()) :
         InputArchive<RPCPortableBinaryInputArchive, AllowEmptyClassElision>(this),
-        itsStream(stream),
         itsConvertEndianness( false )
       {
 		options_.itsInputEndianness = options.itsInputEndianness;
@@ -245,7 +239,14 @@ namespace cereal
 		return (*this);
       }
 
-      //! Reads size bytes of data from the input stream
+      //! Sets the memory block to read from
+      void setbuf( std::string_view s )
+      {
+        itsCurrent = s.data();
+        itsEnd = s.data() + s.size();
+      }
+
+      //! Reads size bytes of data from the memory block
       /*! @param data The data to save
           @param size The number of bytes in the data
           @tparam DataSize T The size of the actual type of the data elements being loaded */
@@ -253,10 +254,11 @@ namespace cereal
       void loadBinary( void * const data, std::streamsize size )
       {
         // load data
-        auto const readSize = itsStream.rdbuf()->sgetn( reinterpret_cast<char*>( data ), size );
+        if( static_cast<std::size_t>( itsEnd - itsCurrent ) < static_cast<std::size_t>( size ) )
+          throw Exception("Failed to read " + std::to_string(size) + " bytes from input buffer! Read " + std::to_string(itsEnd - itsCurrent));
 
-        if(readSize != size)
-          throw Exception("Failed to read " + std::to_string(size) + " bytes from input stream! Read " + std::to_string(readSize));
+        std::memcpy( data, itsCurrent, static_cast<std::size_t>( size ) );
+        itsCurrent += size;
 
         // flip bits if needed
         if( itsConvertEndianness )
@@ -267,8 +269,26 @@ namespace cereal
         }
       }
 
+      //! Reads size bytes without copying, the view points into the memory block
+      std::string_view loadView( std::size_t size )
+      {
+        if( static_cast<std::size_t>( itsEnd - itsCurrent ) < size )
+          throw Exception("Failed to read " + std::to_string(size) + " bytes from input buffer! Read " + std::to_string(itsEnd - itsCurrent));
+
+        std::string_view v( itsCurrent, size );
+        itsCurrent += size;
+        return v;
+      }
+
+      //! The bytes of the memory block which are not read yet
+      std::string_view remain() const
+      {
+        return std::string_view( itsCurrent, static_cast<std::size_t>( itsEnd - itsCurrent ) );
+      }
+
     private:
-      std::istream & itsStream;
+      const char * itsCurrent = nullptr;
+      const char * itsEnd = nullptr;
       uint8_t itsConvertEndianness; //!< If set to true, we will need to swap bytes upon loading
 	  Options options_;
   };
@@ -0,0 +1,334 @@
+/*
+ * COPYRIGHT (C) 2017-2019, zhllxt
+ *
+ * author   : zhllxt
+ * email    : 37792738@qq.com
+ *
+ * Distributed under the GNU GENERAL PUBLIC LICENSE Version 3, 29 June 2007
+ * (See accompanying file LICENSE or see <http://www.gnu.org/licenses/>)
+ */
+
+#ifndef __ASIO2_RPC_TASK_HPP__
+#define __ASIO2_RPC_TASK_HPP__
+
+#if defined(_MSC_VER) && (_MSC_VER >= 1200)
+#pragma once
+#endif // defined(_MSC_VER) && (_MSC_VER >= 1200)
+
+// the coroutine support is enabled when compiled with c++20 (or -fcoroutines)
+#if defined(__cpp_impl_coroutine) && defined(__has_include)
+#if __has_include(<coroutine>)
+#define ASIO2_RPC_COROUTINE
+#endif
+#endif
+
+#if defined(ASIO2_RPC_COROUTINE)
+
+#include <cstdint>
+#include <coroutine>
+#include <atomic>
+#include <exception>
+#include <functional>
+#include <memory>
+#include <optional>
+#include <type_traits>
+#include <utility>
+
+#include <asio2/base/selector.hpp>
+#include <asio2/base/error.hpp>
+
+namespace asio2::detail
+{
+	template<class T> class rpc_task;
+
+	template<class T>
+	class rpc_task_promise_base
+	{
+		template<class> friend class rpc_task;
+
+	public:
+		/**
+		 * resume the awaiting coroutine, or destroy the frame if the task is started by start()
+		 */
+		struct final_awaiter
+		{
+			inline bool await_ready() noexcept { return false; }
+
+			template<class Promise>
+			inline std::coroutine_handle<> await_suspend(std::coroutine_handle<Promise> h) noexcept
+			{
+				auto& p = h.promise();
+				if (p.detached_)
+				{
+					if (p.done_)
+						p.done_();
+					h.destroy();
+					return std::noop_coroutine();
+				}
+				if (p.continuation_)
+					return p.continuation_;
+				return std::noop_coroutine();
+			}
+
+			inline void await_resume() noexcept {}
+		};
+
+		inline std::suspend_always initial_suspend() noexcept { return {}; }
+
+		inline final_awaiter final_suspend() noexcept { return {}; }
+
+		inline void unhandled_exception() noexcept { this->exception_ = std::current_exception(); }
+
+	protected:
+		std::coroutine_handle<>   continuation_;
+
+		std::exception_ptr        exception_;
+
+		std::function<void()>     done_;
+
+		bool                      detached_ = false;
+	};
+
+	template<class T>
+	class rpc_task_promise : public rpc_task_promise_base<T>
+	{
+		template<class> friend class rpc_task;
+
+	public:
+		inline rpc_task<T> get_return_object() noexcept;
+
+		template<class U>
+		inline void return_value(U&& v) { this->value_.emplace(std::forward<U>(v)); }
+
+		inline T result()
+		{
+			if (this->exception_)
+				std::rethrow_exception(this->exception_);
+			return std::move(*(this->value_));
+		}
+
+	protected:
+		std::optional<T> value_;
+	};
+
+	template<>
+	class rpc_task_promise<void> : public rpc_task_promise_base<void>
+	{
+		template<class> friend class rpc_task;
+
+	public:
+		inline rpc_task<void> get_return_object() noexcept;
+
+		inline void return_void() noexcept {}
+
+		inline void result()
+		{
+			if (this->exception_)
+				std::rethrow_exception(this->exception_);
+		}
+	};
+
+	/**
+	 * the lazy coroutine task, the coroutine is started when it's awaited or start() is called.
+	 * the bound rpc function can be a coroutine which returns rpc_task<T>, the response is sent when
+	 * the coroutine is finished, so it can co_await the other rpc calls without blocking the thread.
+	 * the coroutine is resumed in the thread which completes the awaited operation.
+	 */
+	template<class T = void>
+	class rpc_task
+	{
+	public:
+		using promise_type = rpc_task_promise<T>;
+		using value_type = T;
+
+		explicit rpc_task(std::coroutine_handle<promise_type> h) noexcept : handle_(h) {}
+
+		rpc_task(rpc_task&& o) noexcept : handle_(std::exchange(o.handle_, {})) {}
+
+		rpc_task& operator=(rpc_task&& o) noexcept
+		{
+			if (this != &o)
+			{
+				if (this->handle_)
+					this->handle_.destroy();
+				this->handle_ = std::exchange(o.handle_, {});
+			}
+			return (*this);
+		}
+
+		rpc_task(const rpc_task&) = delete;
+		rpc_task& operator=(const rpc_task&) = delete;
+
+		~rpc_task()
+		{
+			if (this->handle_)
+				this->handle_.destroy();
+		}
+
+		inline auto operator co_await() noexcept
+		{
+			struct awaiter
+			{
+				std::coroutine_handle<promise_type> handle_;
+
+				inline bool await_ready() noexcept { return this->handle_.done(); }
+
+				inline std::coroutine_handle<> await_suspend(std::coroutine_handle<> h) noexcept
+				{
+					this->handle_.promise().continuation_ = h;
+					return this->handle_;
+				}
+
+				inline T await_resume() { return this->handle_.promise().result(); }
+			};
+
+			ASIO2_ASSERT(this->handle_);
+
+			return awaiter{ this->handle_ };
+		}
+
+		/**
+		 * @function : start the coroutine without awaiting it, the coroutine frame is destroyed when
+		 * it's finished. the callback is called when the coroutine is finished, it must not throw.
+		 * Callback signature : void(std::exception_ptr ex, std::optional<T> result)
+		 * if T is void, the Callback signature is : void(std::exception_ptr ex)
+		 */
+		template<class Callback>
+		inline void start(Callback&& fn)
+		{
+			std::coroutine_handle<promise_type> h = std::exchange(this->handle_, {});
+
+			ASIO2_ASSERT(h);
+
+			h.promise().detached_ = true;
+			h.promise().done_ = [h, fn = std::forward<Callback>(fn)]() mutable
+			{
+				if constexpr (std::is_void_v<T>)
+					fn(h.promise().exception_);
+				else
+					fn(h.promise().exception_, std::move(h.promise().value_));
+			};
+
+			h.resume();
+		}
+
+		/**
+		 * @function : start the coroutine without awaiting it, the result is discarded.
+		 */
+		inline void start()
+		{
+			this->start([](std::exception_ptr, auto&&...) {});
+		}
+
+	protected:
+		std::coroutine_handle<promise_type> handle_;
+	};
+
+	template<class T>
+	inline rpc_task<T> rpc_task_promise<T>::get_return_object() noexcept
+	{
+		return rpc_task<T>{ std::coroutine_handle<rpc_task_promise<T>>::from_promise(*this) };
+	}
+
+	inline rpc_task<void> rpc_task_promise<void>::get_return_object() noexcept
+	{
+		return rpc_task<void>{ std::coroutine_handle<rpc_task_promise<void>>::from_promise(*this) };
+	}
+
+	template<class T>
+	struct is_rpc_task : std::false_type {};
+
+	template<class T>
+	struct is_rpc_task<rpc_task<T>> : std::true_type {};
+
+	/**
+	 * the awaitable of the co_call, the request is sent when the co_call is called, the response may
+	 * be received before the co_await, so the completion and the suspension race on the flag_.
+	 */
+	template<class T>
+	class rpc_awaitable
+	{
+	protected:
+		struct state
+		{
+			/// set by the first one of the completion and the suspension, the second one resumes
+			std::atomic<bool>          flag_{ false };
+
+			std::coroutine_handle<>    handle_;
+
+			error_code                 ec_;
+
+			std::optional<std::conditional_t<std::is_void_v<T>, std::int8_t, T>> value_;
+		};
+
+	public:
+		explicit rpc_awaitable(error_code* ec) : ec_(ec), state_(std::make_shared<state>()) {}
+
+		/**
+		 * the callback of the async call
+		 */
+		inline auto handler()
+		{
+			if constexpr (std::is_void_v<T>)
+			{
+				return [s = this->state_](const error_code& ec) mutable
+				{
+					s->ec_ = ec;
+					_complete(s);
+				};
+			}
+			else
+			{
+				return [s = this->state_](const error_code& ec, T v) mutable
+				{
+					s->ec_ = ec;
+					s->value_.emplace(std::move(v));
+					_complete(s);
+				};
+			}
+		}
+
+		inline bool await_ready() const noexcept { return false; }
+
+		inline bool await_suspend(std::coroutine_handle<> h) noexcept
+		{
+			this->state_->handle_ = h;
+			return (!this->state_->flag_.exchange(true, std::memory_order_acq_rel));
+		}
+
+		inline T await_resume()
+		{
+			set_last_error(this->state_->ec_);
+
+			if (this->ec_)
+				*(this->ec_) = this->state_->ec_;
+			else
+				asio::detail::throw_error(this->state_->ec_);
+
+			if constexpr (!std::is_void_v<T>)
+				return std::move(*(this->state_->value_));
+		}
+
+	protected:
+		static inline void _complete(std::shared_ptr<state>& s)
+		{
+			if (s->flag_.exchange(true, std::memory_order_acq_rel))
+				s->handle_.resume();
+		}
+
+	protected:
+		error_code               * ec_ = nullptr;
+
+		std::shared_ptr<state>     state_;
+	};
+}
+
+namespace asio2
+{
+	template<class T = void>
+	using rpc_task = detail::rpc_task<T>;
+}
+
+#endif // ASIO2_RPC_COROUTINE
+
+#endif // !__ASIO2_RPC_TASK_HPP__
@@ -15,9 +15,6 @@
 #pragma once
 #endif // defined(_MSC_VER) && (_MSC_VER >= 1200)
 
-#include <istream>
-#include <ostream>
-#include <streambuf>
 #include <string>
 #include <string_view>
 
@@ -30,75 +27,6 @@
 
 namespace asio2::detail
 {
-	class ostrbuf : public std::streambuf
-	{
-	public:
-		using string_type = std::basic_string<char_type, traits_type>;
-		using size_type = typename string_type::size_type;
-
-		ostrbuf() {}
-		virtual ~ostrbuf() {}
-
-		inline const string_type& str() const
-		{
-			return this->str_;
-		}
-
-		inline void clear()
-		{
-			this->str_.clear();
-
-			this->setp(this->str_.data(), this->str_.data() + this->str_.size());
-		}
-
-	protected:
-		virtual std::streamsize xsputn(const char_type* s, std::streamsize count) override
-		{
-			this->str_.append(s, size_type(count));
-
-			this->setp(this->str_.data(), this->str_.data() + this->str_.size());
-
-			return count;
-		}
-
-	protected:
-		string_type str_;
-	};
-
-	class istrbuf : public std::streambuf
-	{
-	public:
-		using string_type = std::basic_string<char_type, traits_type>;
-		using size_type = typename string_type::size_type;
-
-		istrbuf() {}
-		virtual ~istrbuf() {}
-
-		inline void setbuf(std::string_view s)
-		{
-			this->setbuf(const_cast<char_type*>(s.data()), std::streamsize(s.size()));
-		}
-
-		virtual std::streambuf* setbuf(char_type* s, std::streamsize n) override
-		{
-			this->setg(s, s, s + n);
-			return this;
-		}
-
-	protected:
-		virtual std::streamsize xsgetn(char_type* s, std::streamsize count) override
-		{
-			if (std::streamsize(this->egptr() - this->gptr()) < count)
-				return std::streamsize(0);
-
-			std::memcpy((void*)s, (const void*)(this->gptr()), size_type(count));
-
-			this->setg(this->eback(), this->gptr() + count, this->egptr());
-
-			return count;
-		}
-	};
-
 	class serializer
 	{
 	public:
@@ -106,9 +34,10 @@ namespace asio2::detail
 
 		serializer()
 			: obuffer_()
-			, ostream_(&obuffer_)
-			, oarchive_(ostream_)
-		{}
+			, oarchive_(obuffer_)
+		{
+			this->obuffer_.reserve(init_buffer_size);
+		}
 		~serializer() = default;
 
 		template<typename T>
@@ -131,6 +60,9 @@ namespace asio2::detail
 			return (*this);
 		}
 
+		/**
+		 * clear the buffer and keep the capacity, so the small messages never allocate
+		 */
 		inline serializer& reset()
 		{
 			this->obuffer_.clear();
@@ -138,16 +70,17 @@ namespace asio2::detail
 			return (*this);
 		}
 
-		inline const auto& str() const
+		inline const std::string& str() const
 		{
-			return this->obuffer_.str();
+			return this->obuffer_;
 		}
 
-		inline ostrbuf& buffer() { return this->obuffer_; }
+		inline std::string& buffer() { return this->obuffer_; }
 
 	protected:
-		ostrbuf         obuffer_;
-		std::ostream    ostream_;
+		static constexpr std::size_t init_buffer_size = 1024;
+
+		std::string     obuffer_;
 		oarchive        oarchive_;
 	};
 
@@ -157,9 +90,7 @@ namespace asio2::detail
 		using iarchive = cereal::RPCPortableBinaryInputArchive;
 
 		deserializer()
-			: ibuffer_()
-			, istream_(&ibuffer_)
-			, iarchive_(istream_)
+			: iarchive_()
 		{}
 		~deserializer() = default;
 
@@ -187,16 +118,20 @@ namespace asio2::detail
 
 		inline deserializer& reset(std::string_view s)
 		{
-			this->ibuffer_.setbuf(s);
+			this->iarchive_.setbuf(s);
 			this->iarchive_.load_endian();
 			return (*this);
 		}
 
-		inline istrbuf& buffer() { return this->ibuffer_; }
+		/**
+		 * the bytes which are not read yet, e.g. the parameters after the header
+		 */
+		inline std::string_view remain() const
+		{
+			return this->iarchive_.remain();
+		}
 
 	protected:
-		istrbuf         ibuffer_;
-		std::istream    istream_;
 		iarchive        iarchive_;
 	};
 }
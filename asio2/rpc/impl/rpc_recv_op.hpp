@@ -18,6 +18,8 @@
 #include <memory>
 #include <future>
 #include <utility>
+#include <queue>
+#include <string>
 #include <string_view>
 
 #include <asio2/base/selector.hpp>
@@ -66,31 +68,29 @@ namespace asio2::detail
 
 			if /**/ (head.is_request())
 			{
-				try
+				// the caller supports the compact form, so the calls of this side can use it too
+				if (head.compact() || head.is_compact())
+					derive.rpc_compact_ = true;
+
+				if (derive._invoker().executor_)
 				{
-					head.type(rpc_type_rep);
-					sr.reset();
-					sr << head;
-					auto* fn = derive._invoker().find(head.name());
-					if (fn)
-						(*fn)(this_ptr, sr, dr);
-					else
-						sr << error_code{ asio::error::not_found };
+					this->_rpc_post_invoke(this_ptr, s);
+					return;
 				}
-				catch (cereal::exception&) { sr << error_code{ asio::error::no_data }; }
-				catch (system_error& e) { sr << e.code(); }
-				catch (std::exception&) { sr << error_code{ asio::error::eof }; }
 
+				this->_rpc_invoke(this_ptr, head, sr, dr, derive.rpc_compact_);
+
+				// the response of the coroutine function is sent when the coroutine is finished
 				const std::string& str = sr.str();
-				derive.send(str);
+				if (!str.empty())
+					derive.send(str);
 			}
 			else if (head.is_response())
 			{
-				auto iter = derive.reqs_.find(head.id());
-				if (iter == derive.reqs_.end())
-					return;
-				std::function<void(error_code, std::string_view)>& cb = iter->second;
-				cb(error_code{}, s);
+				if (head.is_compact())
+					derive.rpc_compact_ = true;
+
+				derive._rpc_complete(head.id(), error_code{}, s);
 			}
 			else
 			{
@@ -99,8 +99,174 @@ namespace asio2::detail
 			}
 		}
 
+		/**
+		 * call the function of the request and write the response into the sr
+		 */
+		inline void _rpc_invoke(std::shared_ptr<derived_t>& this_ptr, header& head,
+			serializer& sr, deserializer& dr, bool compact)
+		{
+			try
+			{
+				auto* fn = head.is_compact() ?
+					derive._invoker().find(head.method()) :
+					derive._invoker().find(head.name());
+				// reply in the compact form if the caller supports it, the old caller needs the name
+				head.type(compact ? rpc_type_rep_compact : rpc_type_rep);
+				sr.reset();
+				sr << head;
+				if (fn)
+					(*fn)(this_ptr, sr, dr);
+				else
+					sr << error_code{ asio::error::not_found };
+			}
+			catch (cereal::exception&) { sr << error_code{ asio::error::no_data }; }
+			catch (system_error& e) { sr << e.code(); }
+			catch (std::exception&) { sr << error_code{ asio::error::eof }; }
+		}
+
+		/**
+		 * execute the request in the executor of the invoker, the header which is parsed already is
+		 * queued with the parameters, only the parameters are parsed in the executor thread. the
+		 * requests beyond the max_concurrency wait in the queue in order. must be called in the strand.
+		 */
+		inline void _rpc_post_invoke(std::shared_ptr<derived_t>& this_ptr, std::string_view s)
+		{
+			std::string_view args = derive.deserializer_.remain();
+
+			// the endian byte of the frame is kept before the parameters for the deserializer
+			rpc_waiting_request req{ std::move(derive.header_), std::string() };
+			req.args.reserve(1 + args.size());
+			req.args.append(s.data(), 1).append(args);
+
+			this->waiting_.emplace(std::move(req));
+
+			this->_rpc_dispatch_invoke(this_ptr);
+		}
+
+		/**
+		 * post the waiting requests into the executor until the max_concurrency is reached. if the
+		 * executor throws (e.g. it is stopped), the request is answered with operation_aborted and
+		 * the next one is tried in the same loop. must be called in the strand.
+		 */
+		inline void _rpc_dispatch_invoke(std::shared_ptr<derived_t>& this_ptr)
+		{
+			auto& invoker = derive._invoker();
+
+			while (!this->waiting_.empty() &&
+				(!invoker.max_concurrency_ || this->invoking_ < invoker.max_concurrency_))
+			{
+				rpc_waiting_request req = std::move(this->waiting_.front());
+				this->waiting_.pop();
+
+				// the request is moved into the executor, keep what the abort response needs
+				header::id_type id = req.head.id();
+				bool caller_compact = req.head.compact();
+
+				++(this->invoking_);
+
+				try
+				{
+					// the work guard makes the iopool::stop wait until the function is finished, so the
+					// server or client can't be destroyed while the function is executing
+					invoker.executor_([this, this_ptr, req = std::move(req), compact = derive.rpc_compact_,
+						guard = asio::make_work_guard(derive.io().context())]() mutable
+					{
+						// the serializer of the connection is used by the io thread, use the thread local ones
+						thread_local serializer sr;
+						thread_local deserializer dr;
+
+						bool deferred = false;
+
+						try
+						{
+							dr.reset(req.args);
+
+							this->_rpc_invoke(this_ptr, req.head, sr, dr, compact);
+
+							// the coroutine function sends the response and calls the _rpc_invoke_done
+							// when the coroutine is finished
+							deferred = sr.str().empty();
+
+							if (!deferred)
+								derive.send(sr.str());
+						}
+						catch (cereal::exception&) {}
+
+						if (!deferred)
+							this->_rpc_invoke_done(this_ptr);
+					});
+				}
+				catch (std::exception&)
+				{
+					// the executor is stopped
+					--(this->invoking_);
+					set_last_error(asio::error::operation_aborted);
+					this->_rpc_abort_invoke(id, caller_compact);
+				}
+			}
+		}
+
+		/**
+		 * reply the request which can't be executed with operation_aborted, must be called in the strand.
+		 */
+		inline void _rpc_abort_invoke(header::id_type id, bool caller_compact)
+		{
+			serializer& sr = derive.serializer_;
+			header& head = derive.header_;
+
+			// the caller finds the call by the id, the name isn't needed
+			head.type(derive.rpc_compact_ ? rpc_type_rep_compact : rpc_type_rep).id(id).name({}).compact(caller_compact);
+			sr.reset();
+			sr << head;
+			sr << error_code{ asio::error::operation_aborted };
+
+			derive.send(sr.str());
+		}
+
+		/**
+		 * the function executed by the executor is finished, for the coroutine function it's called
+		 * when the coroutine is finished, so the max_concurrency counts the suspended coroutines too.
+		 * it may be called in any thread.
+		 */
+		inline void _rpc_invoke_done(std::shared_ptr<derived_t>& this_ptr)
+		{
+			if (!derive._invoker().executor_)
+				return;
+
+			asio::post(derive.io().strand(), [this, this_ptr]() mutable
+			{
+				this->_rpc_handle_invoked(this_ptr);
+			});
+		}
+
+		inline void _rpc_handle_invoked(std::shared_ptr<derived_t>& this_ptr)
+		{
+			--(this->invoking_);
+
+			if (!derive.is_started())
+			{
+				std::queue<rpc_waiting_request>().swap(this->waiting_);
+				return;
+			}
+
+			this->_rpc_dispatch_invoke(this_ptr);
+		}
+
 	protected:
 		derived_t & derive;
+
+		/// the request which waits for the executor, the header is parsed already
+		struct rpc_waiting_request
+		{
+			header                  head;
+			std::string             args;
+		};
+
+		/// the number of the requests which are executing in the executor
+		std::size_t                 invoking_ = 0;
+
+		/// the requests which wait for the max_concurrency
+		std::queue<rpc_waiting_request> waiting_;
 	};
 }
 
@@ -110,11 +110,10 @@ namespace asio2::detail
 	protected:
 		inline void _handle_disconnect(const error_code& ec, std::shared_ptr<derived_t> this_ptr)
 		{
-			while (!this->reqs_.empty())
-			{
-				auto& fn = this->reqs_.begin()->second;
-				fn(asio::error::operation_aborted, std::string_view{});
-			}
+			this->_rpc_complete_all(asio::error::operation_aborted);
+
+			// the server may be replaced by an old one when reconnecting
+			this->rpc_compact_ = false;
 
 			super::_handle_disconnect(ec, std::move(this_ptr));
 		}
@@ -58,6 +58,7 @@ namespace asio2::detail
 		template <class, bool>         friend class ws_send_op;
 		template <class, bool>         friend class rpc_call_cp;
 		template <class, bool>         friend class rpc_recv_op;
+		template <class>               friend class invoker_t;
 		template <class>               friend class session_mgr_t;
 
 		template <class, class, class>               friend class session_impl_t;
@@ -133,11 +134,7 @@ namespace asio2::detail
 
 		inline void _handle_disconnect(const error_code& ec, std::shared_ptr<derived_t> this_ptr)
 		{
-			while (!this->reqs_.empty())
-			{
-				auto& fn = this->reqs_.begin()->second;
-				fn(asio::error::operation_aborted, std::string_view{});
-			}
+			this->_rpc_complete_all(asio::error::operation_aborted);
 
 			super::_handle_disconnect(ec, std::move(this_ptr));
 		}
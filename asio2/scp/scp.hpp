@@ -237,6 +237,23 @@ namespace asio2::detail
 			return (this->derived());
 		}
 
+		/**
+		 * @function : bind send pressure listener
+		 * @param    : fun - a user defined callback function
+		 * @param    : obj - a pointer or reference to a class object, this parameter can be none
+		 * if fun is nonmember function, the obj param must be none, otherwise the obj must be the
+		 * the class object's pointer or refrence.
+		 * This notification is called when the send queue reaches the high watermark (high is true)
+		 * and when it falls to the low watermark again (high is false), see send_watermark.
+		 * Function signature : void(bool high)
+		 */
+		template<class F, class ...C>
+		inline derived_t & bind_send_pressure(F&& fun, C&&... obj)
+		{
+			this->listener_.bind(event::send_pressure, observer_t<bool>(std::forward<F>(fun), std::forward<C>(obj)...));
+			return (this->derived());
+		}
+
 	public:
 		/**
 		 * @function : get the socket object refrence
@@ -456,6 +473,11 @@ namespace asio2::detail
 		inline std::atomic<state_t>       & state()    { return this->state_;    }
 		inline std::shared_ptr<derived_t>   selfptr()  { return std::shared_ptr<derived_t>{}; }
 
+		inline void _fire_send_pressure(detail::ignore, bool high)
+		{
+			this->listener_.notify(event::send_pressure, std::move(high));
+		}
+
 	protected:
 		/// socket 
 		socket_t                                  socket_;
@@ -17,6 +17,9 @@
 
 #include <memory>
 #include <future>
+#include <array>
+#include <vector>
+#include <iterator>
 #include <utility>
 #include <string_view>
 
@@ -25,6 +28,8 @@
 #include <asio2/base/detail/condition_wrap.hpp>
 #include <asio2/base/detail/buffer_wrap.hpp>
 
+#include <asio2/base/component/event_queue_cp.hpp>
+
 namespace asio2::detail
 {
 	template<class derived_t, bool isSession>
@@ -65,71 +70,107 @@ namespace asio2::detail
 		 */
 		~tcp_send_op() = default;
 
+	public:
+		/**
+		 * @function : set the write coalescing, when the executing send is going to be written and
+		 * there are other sends queued after it, the data of all of them are written by one operation,
+		 * then the callback of each send is called in order.
+		 * max_count : the max number of sends which can be written by one operation, 0 or 1 means disable.
+		 * max_bytes : the max bytes of the coalesced data (the first send is always written).
+		 * it's only for the tcp stream (both the general mode and the dgram mode), the websocket and
+		 * http are not affected, you should call this function before the send.
+		 */
+		inline derived_t & send_coalescing(std::size_t max_count, std::size_t max_bytes = 64 * 1024)
+		{
+			this->coalesce_count_ = max_count;
+			this->coalesce_bytes_ = max_bytes;
+			return (derive);
+		}
+
+		/**
+		 * @function : get the max number of sends which can be written by one operation
+		 */
+		inline std::size_t send_coalescing() const { return this->coalesce_count_; }
+
 	protected:
 		template<class Data, class Callback>
 		inline bool _tcp_send(Data& data, Callback&& callback)
 		{
-			if constexpr (has_member_dgram<derived_t>::value)
+#if defined(ASIO2_SEND_CORE_ASYNC)
+			if (this->coalesce_count_ > 1 && derive._next_queued_event())
 			{
-				if (derive.dgram_)
-				{
-					return derive._tcp_send_dgram(asio::buffer(data), std::forward<Callback>(callback));
-				}
+				return derive._tcp_send_coalesced(to_buffers(data), std::forward<Callback>(callback));
 			}
-			else
+#endif
+
+			if (this->_is_dgram())
 			{
-				std::ignore = true;
+				return derive._tcp_send_dgram(to_buffers(data), std::forward<Callback>(callback));
 			}
 
-			return derive._tcp_send_general(asio::buffer(data), std::forward<Callback>(callback));
+			return derive._tcp_send_general(to_buffers(data), std::forward<Callback>(callback));
 		}
 
-		template<class BufferSequence, class Callback>
-		inline bool _tcp_send_dgram(BufferSequence&& buffer, Callback&& callback)
+		inline bool _is_dgram()
 		{
-			int bytes = 0;
-			std::unique_ptr<std::uint8_t[]> head;
+			if constexpr (has_member_dgram<derived_t>::value)
+			{
+				return derive.dgram_;
+			}
+			else
+			{
+				return false;
+			}
+		}
 
+		/**
+		 * write the dgram header of the data to head, the head must has 9 bytes space at least,
+		 * return the bytes of the header.
+		 */
+		inline std::size_t _dgram_head(std::size_t buffer_size, std::uint8_t* head)
+		{
 			// note : need ensure big endian and little endian
-			if (buffer.size() < std::size_t(254))
+			if (buffer_size < std::size_t(254))
 			{
-				bytes = 1;
-				head = std::make_unique<std::uint8_t[]>(bytes);
-				head[0] = static_cast<std::uint8_t>(buffer.size());
+				head[0] = static_cast<std::uint8_t>(buffer_size);
+				return 1;
 			}
-			else if (buffer.size() <= (std::numeric_limits<std::uint16_t>::max)())
+			else if (buffer_size <= (std::numeric_limits<std::uint16_t>::max)())
 			{
-				bytes = 3;
-				head = std::make_unique<std::uint8_t[]>(bytes);
 				head[0] = static_cast<std::uint8_t>(254);
-				std::uint16_t size = static_cast<std::uint16_t>(buffer.size());
+				std::uint16_t size = static_cast<std::uint16_t>(buffer_size);
 				std::memcpy(&head[1], reinterpret_cast<const void*>(&size), sizeof(std::uint16_t));
 				// use little endian
 				if (!is_little_endian())
 				{
 					swap_bytes<sizeof(std::uint16_t)>(&head[1]);
 				}
+				return 3;
 			}
 			else
 			{
-				ASIO2_ASSERT(buffer.size() > (std::numeric_limits<std::uint16_t>::max)());
-				bytes = 9;
-				head = std::make_unique<std::uint8_t[]>(bytes);
+				ASIO2_ASSERT(buffer_size > (std::numeric_limits<std::uint16_t>::max)());
 				head[0] = static_cast<std::uint8_t>(255);
-				std::uint64_t size = buffer.size();
+				std::uint64_t size = buffer_size;
 				std::memcpy(&head[1], reinterpret_cast<const void*>(&size), sizeof(std::uint64_t));
 				// use little endian
 				if (!is_little_endian())
 				{
 					swap_bytes<sizeof(std::uint64_t)>(&head[1]);
 				}
+				return 9;
 			}
+		}
 
-			std::array<asio::const_buffer, 2> buffers
-			{
-				asio::buffer(reinterpret_cast<const void*>(head.get()), bytes),
-				std::forward<BufferSequence>(buffer)
-			};
+		template<class BufferSequence, class Callback>
+		inline bool _tcp_send_dgram(BufferSequence&& buffer, Callback&& callback)
+		{
+			std::unique_ptr<std::uint8_t[]> head = std::make_unique<std::uint8_t[]>(9);
+
+			std::size_t bytes = this->_dgram_head(asio::buffer_size(buffer), head.get());
+
+			auto buffers = _dgram_buffers(asio::buffer(reinterpret_cast<const void*>(head.get()), bytes),
+				std::forward<BufferSequence>(buffer));
 
 #if defined(ASIO2_SEND_CORE_ASYNC)
 			asio::async_write(derive.stream(), buffers, asio::bind_executor(derive.io().strand(),
@@ -172,6 +213,131 @@ namespace asio2::detail
 #endif
 		}
 
+		template<class BufferSequence>
+		inline auto _dgram_buffers(asio::const_buffer head, BufferSequence&& buffer)
+		{
+			using buffer_type = std::remove_cv_t<std::remove_reference_t<BufferSequence>>;
+			if constexpr (std::is_convertible_v<buffer_type, asio::const_buffer>)
+			{
+				return std::array<asio::const_buffer, 2>{ head, asio::const_buffer(buffer) };
+			}
+			else
+			{
+				// the header and all the buffers of the sequence are written by one operation
+				std::vector<asio::const_buffer> buffers;
+				buffers.reserve(std::distance(asio::buffer_sequence_begin(buffer),
+					asio::buffer_sequence_end(buffer)) + 1);
+				buffers.emplace_back(head);
+				for (auto it = asio::buffer_sequence_begin(buffer); it != asio::buffer_sequence_end(buffer); ++it)
+				{
+					buffers.emplace_back(*it);
+				}
+				return buffers;
+			}
+		}
+
+#if defined(ASIO2_SEND_CORE_ASYNC)
+		struct coalesced_message
+		{
+			std::unique_ptr<event_base> event;
+			std::size_t                 head_size;
+			std::size_t                 body_size;
+		};
+
+		/**
+		 * gather the data of the executing send and the sends queued after it, and write them by one
+		 * operation. the queued sends are detached from the event queue, their callbacks are called
+		 * after the write is completed.
+		 */
+		template<class BufferSequence, class Callback>
+		inline bool _tcp_send_coalesced(BufferSequence&& buffer, Callback&& callback)
+		{
+			bool dgram = this->_is_dgram();
+
+			// 9 bytes for the dgram header of each message at most
+			std::unique_ptr<std::uint8_t[]> heads = dgram ?
+				std::make_unique<std::uint8_t[]>(9 * this->coalesce_count_) : nullptr;
+
+			std::vector<asio::const_buffer> buffers;
+			std::vector<coalesced_message> messages;
+			messages.reserve(this->coalesce_count_);
+
+			std::size_t total = 0;
+
+			// the first is the data of the executing send, it's always written
+			for (event_base * e = nullptr; messages.size() < this->coalesce_count_;
+				e = derive._next_queued_event())
+			{
+				std::size_t pos = buffers.size();
+
+				if (dgram)
+					buffers.emplace_back();
+
+				if (messages.empty())
+					buffers.insert(buffers.end(), asio::buffer_sequence_begin(buffer), asio::buffer_sequence_end(buffer));
+				else if (!e || !e->gather(buffers))
+				{
+					buffers.resize(pos);
+					break;
+				}
+
+				std::size_t body_size = 0;
+				for (std::size_t i = pos + (dgram ? 1 : 0); i < buffers.size(); ++i)
+					body_size += buffers[i].size();
+
+				if (!messages.empty() && total + body_size > this->coalesce_bytes_)
+				{
+					buffers.resize(pos);
+					break;
+				}
+
+				std::size_t head_size = 0;
+				if (dgram)
+				{
+					std::uint8_t * head = heads.get() + 9 * messages.size();
+					head_size = this->_dgram_head(body_size, head);
+					buffers[pos] = asio::buffer(reinterpret_cast<const void*>(head), head_size);
+				}
+
+				total += body_size;
+
+				messages.emplace_back(coalesced_message{ messages.empty() ?
+					std::unique_ptr<event_base>{} : derive._detach_next_queued_event(), head_size, body_size });
+			}
+
+			asio::async_write(derive.stream(), buffers, asio::bind_executor(derive.io().strand(),
+				make_allocator(derive.wallocator(),
+					[this, p = derive.selfptr(), heads = std::move(heads), messages = std::move(messages),
+					callback = std::forward<Callback>(callback)]
+			(const error_code& ec, std::size_t bytes_sent) mutable
+			{
+				set_last_error(ec);
+
+				// the sent bytes are distributed to the messages in order
+				for (auto & m : messages)
+				{
+					std::size_t n = (std::min)(bytes_sent, m.head_size + m.body_size);
+					bytes_sent -= n;
+					n = (n > m.head_size ? n - m.head_size : 0);
+
+					if (m.event)
+						m.event->complete(ec, n);
+					else
+						callback(ec, n);
+				}
+
+				if (ec)
+				{
+					// must stop, otherwise re-sending will cause body confusion
+					derive._do_disconnect(ec);
+				}
+
+				derive.next_event();
+			})));
+			return true;
+		}
+#endif
+
 		template<class BufferSequence, class Callback>
 		inline bool _tcp_send_general(BufferSequence&& buffer, Callback&& callback)
 		{
@@ -210,6 +376,12 @@ namespace asio2::detail
 
 	protected:
 		derived_t & derive;
+
+		/// the max number of sends which can be written by one operation, 0 or 1 means disable
+		std::size_t coalesce_count_ = 0;
+
+		/// the max bytes of the coalesced data
+		std::size_t coalesce_bytes_ = 64 * 1024;
 	};
 }
 
@@ -31,6 +31,45 @@ namespace asio2::detail
 		using super = server_impl_t<derived_t, session_t>;
 		using session_type = session_t;
 
+	protected:
+		/**
+		 * the accept state of a listening socket, it's only used in the io which accepts on the socket.
+		 */
+		struct accept_context
+		{
+			explicit accept_context(io_t & io_ref)
+				: io(io_ref), timer(io_ref.context()), reserve(io_ref.context()) {}
+
+			io_t                    & io;
+
+			/// timer for acceptor exception, like the exception "Too many open files" (exception code : 24)
+			asio::steady_timer        timer;
+
+			/// the reserved descriptor, it's released to shed the pending connections when the descriptors are exhausted
+			asio::ip::tcp::socket     reserve;
+
+			/// the current backoff delay
+			std::chrono::milliseconds backoff{ 0 };
+
+			/// the number of the accept operations which are waiting for the backoff timer
+			std::size_t               parked = 0;
+
+			handler_memory<>          allocator;
+		};
+
+		/**
+		 * the listening socket of the reuse port mode, it's bound to the io which accepts on it.
+		 */
+		struct reuse_port_acceptor
+		{
+			explicit reuse_port_acceptor(io_t & io_ref) : acceptor(io_ref.context()), context(io_ref) {}
+
+			asio::ip::tcp::acceptor   acceptor;
+
+			accept_context            context;
+		};
+
+	public:
 		/**
 		 * @constructor
 		 */
@@ -41,7 +80,7 @@ namespace asio2::detail
 		)
 			: super(concurrency)
 			, acceptor_(this->io_.context())
-			, acceptor_timer_(this->io_.context())
+			, accept_ctx_(this->io_)
 			, counter_timer_(this->io_.context())
 			, init_buffer_size_(init_buffer_size)
 			, max_buffer_size_(max_buffer_size)
@@ -119,6 +158,88 @@ namespace asio2::detail
 			ASIO2_ASSERT(this->state_ == state_t::stopped);
 		}
 
+		/**
+		 * @function : enable the session pool, the released sessions are recycled and reused by the
+		 * next accepted connections, so the session objects (include the socket, timers, buffer and
+		 * allocators) needn't be created and destroyed for each connection.
+		 * max_count : the max number of the recycled sessions kept by the pool, 0 means disable.
+		 * You should call this function before start. It's only supported by the tcp_server, the
+		 * session of the ssl, http, websocket and rpc server has state which can't be recycled.
+		 * A recycled session is reset to the defaults of a new session, include the silence timeout,
+		 * the send coalescing, the send watermarks and the send queue policy.
+		 */
+		inline derived_t & session_pool(std::size_t max_count)
+		{
+			static_assert(is_poolable_session<session_t>::value,
+				"the session pool is only supported by the tcp_server");
+
+			if (max_count)
+				this->session_pool_ = std::make_shared<session_pool_t<session_t>>(max_count);
+			else
+				this->session_pool_.reset();
+			return (this->derived());
+		}
+
+		/**
+		 * @function : get the counters of the session pool, the reuse rate is : reused / (created + reused)
+		 */
+		inline session_pool_stats pool_stats()
+		{
+			return (this->session_pool_ ? this->session_pool_->stats() : session_pool_stats{});
+		}
+
+		/**
+		 * @function : enable the reuse port mode, the server opens a listening socket with the SO_REUSEPORT
+		 * option for each io_context of the iopool, and each listening socket accepts connections on its
+		 * own io thread, the kernel balances the incoming connections among the listening sockets, so the
+		 * session is created on the io thread which accepts it, and the accepting is not serialized on the
+		 * acceptor io thread any more.
+		 * You should call this function before start. It's only supported on linux, on the other platforms
+		 * the server falls back to the single listening socket.
+		 */
+		inline derived_t & reuse_port(bool enable)
+		{
+			this->reuse_port_ = enable;
+			return (this->derived());
+		}
+
+		/**
+		 * @function : check whether the reuse port mode is enabled
+		 */
+		inline bool reuse_port() const
+		{
+			return this->reuse_port_;
+		}
+
+		/**
+		 * @function : set the number of the async_accept operations which are outstanding at the same time on
+		 * each listening socket, and the max number of the connections which are accepted in a loop without
+		 * waiting when an async_accept is completed, so the backlog is drained faster in a connection storm.
+		 * You should call this function before start.
+		 */
+		inline derived_t & accept_concurrency(std::size_t count, std::size_t batch = 16)
+		{
+			this->accept_count_ = (std::max)(count, std::size_t(1));
+			this->accept_batch_ = (std::max)(batch, std::size_t(1));
+			return (this->derived());
+		}
+
+		/**
+		 * @function : get the number of the outstanding async_accept operations on each listening socket
+		 */
+		inline std::size_t accept_concurrency() const
+		{
+			return this->accept_count_;
+		}
+
+		/**
+		 * @function : get the number of the listening sockets
+		 */
+		inline std::size_t acceptor_count() const
+		{
+			return (this->acceptors_.size() + 1);
+		}
+
 		/**
 		 * @function : check whether the server is started 
 		 */
@@ -271,6 +392,9 @@ namespace asio2::detail
 
 				this->iopool_.start();
 
+				if (this->session_pool_)
+					this->session_pool_->open();
+
 				if (this->iopool_.is_stopped())
 				{
 					set_last_error(asio::error::shut_down);
@@ -309,8 +433,42 @@ namespace asio2::detail
 
 				this->derived()._fire_init();
 
+				this->acceptors_.clear();
+
+				bool reuse_port = (this->reuse_port_ && this->_reuse_port_supported() && this->iopool_.size() > 1);
+
+				if (reuse_port)
+					this->_set_reuse_port(this->acceptor_);
+
 				this->acceptor_.bind(endpoint);
 				this->acceptor_.listen();
+				this->acceptor_.non_blocking(true);
+
+				this->_reset_accept_context(this->accept_ctx_);
+
+				if (reuse_port)
+				{
+					// if the port is 0, the other listening sockets must be bound to the port which is chosen
+					// by the system for the first listening socket
+					endpoint = this->acceptor_.local_endpoint();
+
+					for (std::size_t i = 1; i < this->iopool_.size(); ++i)
+					{
+						std::unique_ptr<reuse_port_acceptor> p =
+							std::make_unique<reuse_port_acceptor>(this->iopool_.get(i));
+
+						p->acceptor.open(endpoint.protocol());
+						p->acceptor.set_option(asio::ip::tcp::acceptor::reuse_address(true));
+						this->_set_reuse_port(p->acceptor);
+						p->acceptor.bind(endpoint);
+						p->acceptor.listen();
+						p->acceptor.non_blocking(true);
+
+						this->_reset_accept_context(p->context);
+
+						this->acceptors_.emplace_back(std::move(p));
+					}
+				}
 
 				this->derived()._handle_start(error_code{}, std::move(condition));
 
@@ -345,10 +503,16 @@ namespace asio2::detail
 
 				asio::detail::throw_error(ec);
 
-				asio::post(this->io_.strand(), [this, condition]()
+				for (std::size_t i = 0; i < this->acceptor_count(); ++i)
 				{
-					this->derived()._post_accept(std::move(condition));
-				});
+					asio::post(this->_accept_context(i).io.strand(), [this, i, condition]()
+					{
+						for (std::size_t n = 0; n < this->accept_count_; ++n)
+						{
+							this->derived()._post_accept(i, condition);
+						}
+					});
+				}
 			}
 			catch (system_error & e)
 			{
@@ -387,7 +551,7 @@ namespace asio2::detail
 					session_ptr->stop();
 				});
 
-				this->counter_ptr_.reset();
+				this->_release_counter();
 			});
 		}
 
@@ -399,7 +563,7 @@ namespace asio2::detail
 
 			try
 			{
-				this->acceptor_timer_.cancel();
+				this->accept_ctx_.timer.cancel();
 				this->counter_timer_.cancel();
 			}
 			catch (system_error &) {}
@@ -412,31 +576,107 @@ namespace asio2::detail
 			// then the listen socket can get notify to exit
 			// must ensure the close function has been called,otherwise the _handle_accept will never return
 			this->acceptor_.close(ec_ignore);
+			this->accept_ctx_.reserve.close(ec_ignore);
+
+			// the other listening sockets must be closed on their own io thread
+			for (std::unique_ptr<reuse_port_acceptor> & p : this->acceptors_)
+			{
+				asio::post(p->context.io.strand(), [p = p.get()]()
+				{
+					try
+					{
+						p->context.timer.cancel();
+					}
+					catch (system_error &) {}
+					catch (std::exception &) {}
+
+					p->acceptor.close(ec_ignore);
+					p->context.reserve.close(ec_ignore);
+				});
+			}
+
+			// the recycled sessions must be destroyed before the io_context is stopped
+			if (this->session_pool_)
+				this->session_pool_->close();
 		}
 
 		template<typename... Args>
 		inline std::shared_ptr<session_t> _make_session(Args&&... args)
 		{
-			return std::make_shared<session_t>(std::forward<Args>(args)..., this->sessions_, this->listener_,
-				this->iopool_.get(), this->init_buffer_size_, this->max_buffer_size_);
+			if (!this->session_pool_)
+				return std::make_shared<session_t>(std::forward<Args>(args)..., this->sessions_, this->listener_,
+					this->_session_io(), this->init_buffer_size_, this->max_buffer_size_);
+
+			io_t & io = this->_session_io();
+			return this->session_pool_->acquire(io, [&]()
+			{
+				return new session_t(std::forward<Args>(args)..., this->sessions_, this->listener_,
+					io, this->init_buffer_size_, this->max_buffer_size_);
+			});
+		}
+
+		/**
+		 * in the reuse port mode, the session is created on the io which accepts it.
+		 */
+		inline io_t & _session_io()
+		{
+			if (this->acceptors_.empty())
+				return this->iopool_.get();
+
+			if (this->io_.strand().running_in_this_thread())
+				return this->io_;
+
+			for (std::unique_ptr<reuse_port_acceptor> & p : this->acceptors_)
+			{
+				if (p->context.io.strand().running_in_this_thread())
+					return p->context.io;
+			}
+			return this->iopool_.get();
+		}
+
+		/**
+		 * the listening socket 0 is the acceptor_, the others are the reuse port listening sockets
+		 */
+		inline asio::ip::tcp::acceptor & _acceptor(std::size_t index)
+		{
+			return (index == 0 ? this->acceptor_ : this->acceptors_[index - 1]->acceptor);
+		}
+
+		inline accept_context & _accept_context(std::size_t index)
+		{
+			return (index == 0 ? this->accept_ctx_ : this->acceptors_[index - 1]->context);
+		}
+
+		inline void _reset_accept_context(accept_context & ctx)
+		{
+			ctx.backoff = std::chrono::milliseconds(0);
+			ctx.parked = 0;
+
+			// it's not fatal if the descriptor can't be reserved, only the shedding is disabled
+			ctx.reserve.close(ec_ignore);
+			ctx.reserve.open(asio::ip::tcp::v4(), ec_ignore);
 		}
 
 		template<typename MatchCondition>
-		inline void _post_accept(condition_wrap<MatchCondition> condition)
+		inline void _post_accept(std::size_t index, condition_wrap<MatchCondition> condition,
+			std::shared_ptr<session_t> session_ptr = nullptr)
 		{
 			if (!this->is_started())
 				return;
 
+			accept_context & ctx = this->_accept_context(index);
+
 			try
 			{
-				std::shared_ptr<session_t> session_ptr = this->derived()._make_session();
+				if (!session_ptr)
+					session_ptr = this->derived()._make_session();
 
 				auto & socket = session_ptr->socket().lowest_layer();
-				this->acceptor_.async_accept(socket, asio::bind_executor(this->io_.strand(),
-					make_allocator(this->allocator_,
-						[this, sptr = std::move(session_ptr), condition](const error_code & ec)
+				this->_acceptor(index).async_accept(socket, asio::bind_executor(ctx.io.strand(),
+					make_allocator(ctx.allocator,
+						[this, index, sptr = std::move(session_ptr), condition](const error_code & ec)
 				{
-					this->derived()._handle_accept(ec, std::move(sptr), std::move(condition));
+					this->derived()._handle_accept(ec, index, std::move(sptr), std::move(condition));
 				})));
 			}
 			// handle exception,may be is the exception "Too many open files" (exception code : 24)
@@ -444,22 +684,150 @@ namespace asio2::detail
 			{
 				set_last_error(e);
 
-				this->acceptor_timer_.expires_after(std::chrono::seconds(1));
-				this->acceptor_timer_.async_wait(asio::bind_executor(this->io_.strand(),
-					make_allocator(this->allocator_, [this, condition](const error_code & ec)
+				this->derived()._park_accept(index, std::move(condition));
+			}
+		}
+
+		/**
+		 * wait for the backoff delay and then post the accept again, the delay is doubled for each consecutive
+		 * error from 1 millisecond up to 1 second, and it's reset when a connection is accepted.
+		 */
+		template<typename MatchCondition>
+		inline void _park_accept(std::size_t index, condition_wrap<MatchCondition> condition)
+		{
+			accept_context & ctx = this->_accept_context(index);
+
+			// all the parked accept operations are posted again by the same timer
+			if (ctx.parked++ > 0)
+				return;
+
+			ctx.backoff = (std::min)((std::max)(ctx.backoff * 2, std::chrono::milliseconds(1)),
+				std::chrono::milliseconds(1000));
+
+			ctx.timer.expires_after(ctx.backoff);
+			ctx.timer.async_wait(asio::bind_executor(ctx.io.strand(),
+				make_allocator(ctx.allocator, [this, index, condition](const error_code & ec)
+			{
+				set_last_error(ec);
+
+				accept_context & ctx = this->_accept_context(index);
+
+				std::size_t parked = ctx.parked;
+				ctx.parked = 0;
+
+				if (ec) return;
+
+				for (std::size_t n = 0; n < parked; ++n)
 				{
-					set_last_error(ec);
-					if (ec) return;
-					asio::post(this->io_.strand(), make_allocator(this->allocator_, [this, condition]()
-					{
-						this->derived()._post_accept(std::move(condition));
-					}));
-				})));
+					this->derived()._post_accept(index, condition);
+				}
+			})));
+		}
+
+		/**
+		 * accept the connections which are already in the backlog without waiting for another async_accept,
+		 * return the session which is created but not used, it will be used by the next async_accept.
+		 */
+		template<typename MatchCondition>
+		inline std::shared_ptr<session_t> _drain_accept(std::size_t index, condition_wrap<MatchCondition> & condition)
+		{
+			asio::ip::tcp::acceptor & acceptor = this->_acceptor(index);
+
+			std::shared_ptr<session_t> session_ptr;
+
+			// the accept will block if the acceptor was set to blocking mode by the user
+			if (!acceptor.non_blocking())
+				return session_ptr;
+
+			try
+			{
+				for (std::size_t n = 1; n < this->accept_batch_ && this->is_started(); ++n)
+				{
+					if (!session_ptr)
+						session_ptr = this->derived()._make_session();
+
+					error_code ec;
+					acceptor.accept(session_ptr->socket().lowest_layer(), ec);
+
+					// would_block means the backlog is empty, the other errors are handled by the async_accept
+					if (ec)
+						break;
+
+					this->derived()._start_session(session_ptr, condition);
+
+					session_ptr.reset();
+				}
 			}
+			catch (system_error &) {}
+
+			return session_ptr;
+		}
+
+		/**
+		 * when the descriptors are exhausted, release the reserved descriptor, accept the pending connections
+		 * and reset them at once, then reserve the descriptor again. so the clients are refused immediately
+		 * instead of waiting in the backlog until timeout.
+		 */
+		inline void _shed_accept(std::size_t index)
+		{
+			accept_context & ctx = this->_accept_context(index);
+			asio::ip::tcp::acceptor & acceptor = this->_acceptor(index);
+
+			if (!ctx.reserve.is_open() || !acceptor.non_blocking())
+				return;
+
+			ctx.reserve.close(ec_ignore);
+
+			asio::ip::tcp::socket socket(ctx.io.context());
+
+			for (std::size_t n = 0; n < this->accept_batch_; ++n)
+			{
+				error_code ec;
+				acceptor.accept(socket, ec);
+				if (ec)
+					break;
+
+				socket.set_option(asio::socket_base::linger(true, 0), ec_ignore);
+				socket.close(ec_ignore);
+			}
+
+			ctx.reserve.open(asio::ip::tcp::v4(), ec_ignore);
+		}
+
+		static inline bool _is_resource_error(const error_code & ec)
+		{
+			if (ec == asio::error::no_descriptors || ec == asio::error::no_buffer_space ||
+				ec == asio::error::no_memory)
+				return true;
+		#if defined(ENFILE)
+			if (ec.category() == asio::error::get_system_category() && ec.value() == ENFILE)
+				return true;
+		#endif
+			return false;
 		}
 
 		template<typename MatchCondition>
-		inline void _handle_accept(const error_code & ec, std::shared_ptr<session_t> session_ptr,
+		inline void _start_session(std::shared_ptr<session_t> & session_ptr, condition_wrap<MatchCondition> & condition)
+		{
+			if (!this->is_started())
+				return;
+
+			// the counter is released by the stopping in the acceptor io thread
+			std::shared_ptr<void> counter_ptr = this->_load_counter();
+			if (!counter_ptr)
+				return;
+
+			session_ptr->counter_ptr_ = std::move(counter_ptr);
+			session_ptr->start(condition);
+
+			// the server may be stopped by another thread during the starting, if the stopping has
+			// traversed the sessions before this session is joined, this session must stop itself.
+			if (!this->is_started())
+				session_ptr->stop();
+		}
+
+		template<typename MatchCondition>
+		inline void _handle_accept(const error_code & ec, std::size_t index, std::shared_ptr<session_t> session_ptr,
 			condition_wrap<MatchCondition> condition)
 		{
 			set_last_error(ec);
@@ -471,16 +839,27 @@ namespace asio2::detail
 				return;
 			}
 
-			if (!ec)
+			if (ec)
 			{
-				if (this->is_started())
+				// if the descriptors or the memory are exhausted, the accept will fail again immediately, so
+				// shed the pending connections and back off.
+				if (this->_is_resource_error(ec))
 				{
-					session_ptr->counter_ptr_ = this->counter_ptr_;
-					session_ptr->start(condition);
+					this->derived()._shed_accept(index);
+					this->derived()._park_accept(index, std::move(condition));
+					return;
 				}
+
+				// the other errors, like the connection is aborted by the peer, only affect this connection
+				this->derived()._post_accept(index, std::move(condition));
+				return;
 			}
 
-			this->derived()._post_accept(std::move(condition));
+			this->_accept_context(index).backoff = std::chrono::milliseconds(0);
+
+			this->derived()._start_session(session_ptr, condition);
+
+			this->derived()._post_accept(index, condition, this->derived()._drain_accept(index, condition));
 		}
 
 		inline void _fire_init()
@@ -502,8 +881,8 @@ namespace asio2::detail
 		/// acceptor to accept client connection
 		asio::ip::tcp::acceptor acceptor_;
 
-		/// timer for acceptor exception, like the exception "Too many open files" (exception code : 24)
-		asio::steady_timer      acceptor_timer_;
+		/// the accept state of the acceptor_
+		accept_context          accept_ctx_;
 
 		/// used to hold the acceptor io_context util all sessions are closed already.
 		asio::steady_timer      counter_timer_;
@@ -511,6 +890,21 @@ namespace asio2::detail
 		std::size_t             init_buffer_size_ = tcp_frame_size;
 
 		std::size_t             max_buffer_size_ = (std::numeric_limits<std::size_t>::max)();
+
+		/// the pool of the released sessions, nullptr means disable
+		std::shared_ptr<session_pool_t<session_t>> session_pool_;
+
+		/// whether open a listening socket for each io with SO_REUSEPORT
+		bool                    reuse_port_ = false;
+
+		/// the listening sockets of the io 1 ~ n in the reuse port mode, the io 0 uses the acceptor_
+		std::vector<std::unique_ptr<reuse_port_acceptor>> acceptors_;
+
+		/// the number of the outstanding async_accept operations on each listening socket
+		std::size_t             accept_count_ = 1;
+
+		/// the max number of the connections accepted in a loop when an async_accept is completed
+		std::size_t             accept_batch_ = 16;
 	};
 }
 
@@ -45,6 +45,7 @@ namespace asio2::detail
 		template <class>                      friend class session_mgr_t;
 		template <class, class, class>        friend class session_impl_t;
 		template <class, class>               friend class tcp_server_impl_t;
+		template <class>                      friend class session_pool_t;
 
 	public:
 		using self = tcp_session_impl_t<derived_t, socket_t, buffer_t>;
@@ -200,6 +201,14 @@ namespace asio2::detail
 			this->derived()._join_session(std::move(this_ptr), std::move(condition));
 		}
 
+		inline void _recycle()
+		{
+			super::_recycle();
+
+			this->silence_timeout(std::chrono::milliseconds(tcp_silence_timeout));
+			this->send_coalescing(0);
+		}
+
 		inline void _do_disconnect(const error_code& ec)
 		{
 			state_t expected = state_t::starting;
@@ -383,4 +392,10 @@ namespace asio2
 	};
 }
 
+namespace asio2::detail
+{
+	template<>
+	struct is_poolable_session<asio2::tcp_session> : std::true_type {};
+}
+
 #endif // !__ASIO2_TCP_SESSION_HPP__
@@ -27,6 +27,7 @@
 #include <asio2/base/detail/buffer_wrap.hpp>
 
 #include <asio2/udp/detail/kcp_util.hpp>
+#include <asio2/udp/detail/kcp_fec.hpp>
 
 namespace asio2::detail
 {
@@ -42,12 +43,31 @@ namespace asio2::detail
 		template <class, class, class> friend class udp_session_impl_t;
 		template <class, class, class> friend class udp_client_impl_t;
 
+	protected:
+		/**
+		 * the kcp update timer, it's driven by the timer wheel of the io, it holds the session
+		 * until it's expired or canceled, like the handler of a steady_timer does.
+		 */
+		struct kcp_timer_node : public timer_wheel_node
+		{
+			explicit kcp_timer_node(kcp_stream_cp & owner) : owner_(owner) {}
+
+			void on_wheel_timer() override
+			{
+				this->owner_._handle_kcp_timer(std::move(this->self_));
+			}
+
+			kcp_stream_cp              & owner_;
+
+			std::shared_ptr<derived_t>   self_;
+		};
+
 	public:
 		/**
 		 * @constructor
 		 */
 		kcp_stream_cp(derived_t & d, io_t & io)
-			: derive(d), kcp_io_(io), kcp_timer_(io.context())
+			: derive(d), kcp_io_(io), kcp_timer_(*this)
 		{
 		}
 
@@ -56,6 +76,10 @@ namespace asio2::detail
 		 */
 		~kcp_stream_cp()
 		{
+			// the timer node of the session holds the session, but the client doesn't
+			if (this->kcp_timer_.is_linked())
+				this->kcp_io_.wheel().cancel(this->kcp_timer_);
+
 			if (this->kcp_)
 			{
 				kcp::ikcp_release(this->kcp_);
@@ -75,12 +99,69 @@ namespace asio2::detail
 			this->kcp_ = kcp::ikcp_create(conv, (void*)this);
 			this->kcp_->output = &kcp_stream_cp<derived_t, isSession>::_kcp_output;
 
-			kcp::ikcp_nodelay(this->kcp_, 1, 10, 2, 1);
-			kcp::ikcp_wndsize(this->kcp_, 128, 512);
+			// the mtu, the stream mode and the fec are fixed after the handshake, the fec header is
+			// added to each kcp packet, the datagram must not exceed the mtu
+			int mtu = static_cast<int>(derive.kcp_config_.frame_size());
+			if (this->fec_)
+				mtu -= static_cast<int>(kcp_fec::overhead);
+
+			kcp::ikcp_setmtu(this->kcp_, mtu);
+
+			this->kcp_->stream = (derive.kcp_config_.stream ? 1 : 0);
+
+			this->_kcp_apply();
 
 			this->_post_kcp_timer(std::move(this_ptr));
 		}
 
+		/**
+		 * apply the local parameters of the kcp config of the session or client, the mtu, the stream
+		 * mode and the fec are set by the _kcp_start only, must be called in the io strand
+		 */
+		inline void _kcp_apply()
+		{
+			if (!this->kcp_)
+				return;
+
+			const kcp_config & config = derive.kcp_config_;
+
+			kcp::ikcp_nodelay(this->kcp_, config.nodelay, config.interval, config.resend, config.nc);
+			kcp::ikcp_wndsize(this->kcp_, config.sndwnd, config.rcvwnd);
+
+			if (config.minrto > 0)
+				this->kcp_->rx_minrto = config.minrto;
+
+			// the interval may be shortened, update the expiry of the scheduled timer
+			if (this->kcp_timer_.is_linked())
+			{
+				std::uint32_t clock1 = static_cast<std::uint32_t>(std::chrono::duration_cast<
+					std::chrono::milliseconds>(std::chrono::steady_clock::now().time_since_epoch()).count());
+				std::uint32_t clock2 = kcp::ikcp_check(this->kcp_, clock1);
+
+				this->kcp_io_.wheel().schedule(this->kcp_timer_, clock2 - clock1);
+			}
+		}
+
+		/**
+		 * tune the kcp after the handshake, must be called in the io strand. only the local parameters
+		 * are changed, the mtu, the stream mode and the fec are a part of the wire protocol which is
+		 * agreed with the peer by the handshake, so they are kept.
+		 */
+		inline void _kcp_tune(const kcp_config & config)
+		{
+			kcp_config & c = derive.kcp_config_;
+
+			c.nodelay  = config.nodelay;
+			c.interval = config.interval;
+			c.resend   = config.resend;
+			c.nc       = config.nc;
+			c.sndwnd   = config.sndwnd;
+			c.rcvwnd   = config.rcvwnd;
+			c.minrto   = config.minrto;
+
+			this->_kcp_apply();
+		}
+
 		inline void _kcp_stop(std::shared_ptr<derived_t> this_ptr)
 		{
 			detail::ignore::unused(this_ptr);
@@ -90,39 +171,90 @@ namespace asio2::detail
 			if (this->send_fin_)
 				this->_kcp_send_hdr(kcp::make_kcphdr_fin(0), ec);
 
-			this->kcp_timer_.cancel();
+			// the timer wheel can only be used in the io strand
+			if (this->kcp_io_.strand().running_in_this_thread())
+				return this->_cancel_kcp_timer();
+
+			asio::post(this->kcp_io_.strand(), [this, this_ptr = std::move(this_ptr)]()
+			{
+				this->_cancel_kcp_timer();
+			});
+		}
+
+		inline void _cancel_kcp_timer()
+		{
+			this->kcp_io_.wheel().cancel(this->kcp_timer_);
+
+			// release the session after the node is unlinked, the this_ptr of the caller holds it
+			this->kcp_timer_.self_.reset();
+		}
+
+		/**
+		 * create the fec by the negotiated shards, 0 means disable
+		 */
+		inline void _kcp_fec(std::size_t data, std::size_t parity)
+		{
+			if (data > 0 && parity > 0)
+				this->fec_ = std::make_unique<kcp_fec>(data, parity, derive.kcp_config_.frame_size());
+			else
+				this->fec_.reset();
+		}
+
+		/**
+		 * make the synack which carries the fec shards of this session
+		 */
+		inline kcp::kcphdr _kcp_synack(std::uint32_t ack)
+		{
+			return kcp::make_kcphdr_synack(this->seq_, ack,
+				static_cast<std::uint16_t>(this->fec_ ? this->fec_->data_shards  () : 0),
+				static_cast<std::uint16_t>(this->fec_ ? this->fec_->parity_shards() : 0));
 		}
 
 	protected:
-		inline std::size_t _kcp_send_hdr(kcp::kcphdr hdr, error_code& ec)
+		inline std::size_t _kcp_send_raw(const void * data, std::size_t size, error_code& ec)
 		{
 			std::size_t sent_bytes = 0;
 			if constexpr (isSession)
-				sent_bytes = derive.stream().send_to(
-					asio::buffer((const void*)&hdr, sizeof(kcp::kcphdr)),
-					derive.remote_endpoint_, 0, ec);
+				sent_bytes = derive.stream().send_to(asio::buffer(data, size), derive.remote_endpoint_, 0, ec);
 			else
-				sent_bytes = derive.stream().send(
-					asio::buffer((const void*)&hdr, sizeof(kcp::kcphdr)), 0, ec);
+				sent_bytes = derive.stream().send(asio::buffer(data, size), 0, ec);
 			return sent_bytes;
 		}
 
+		inline std::size_t _kcp_send_hdr(kcp::kcphdr hdr, error_code& ec)
+		{
+			return this->_kcp_send_raw((const void*)&hdr, sizeof(kcp::kcphdr), ec);
+		}
+
 		template<class Data, class Callback>
 		inline bool _kcp_send(Data& data, Callback&& callback)
 		{
-			auto buffer = asio::buffer(data);
+			using buffers_type = std::remove_cv_t<std::remove_reference_t<decltype(to_buffers(data))>>;
 
-			int ret = kcp::ikcp_send(this->kcp_, (const char *)buffer.data(), (int)buffer.size());
-			set_last_error(ret);
-			if (ret == 0)
-				kcp::ikcp_flush(this->kcp_);
-			callback(get_last_error(), ret < 0 ? 0 : buffer.size());
+			// kcp need a continuous buffer, so the buffer sequence must be linearized first
+			if constexpr (!std::is_convertible_v<buffers_type, asio::const_buffer>)
+			{
+				auto buffers = to_buffers(data);
+				std::string s(asio::buffer_size(buffers), '\0');
+				asio::buffer_copy(asio::buffer(s), buffers);
+				return this->_kcp_send(s, std::forward<Callback>(callback));
+			}
+			else
+			{
+				auto buffer = asio::buffer(data);
+
+				int ret = kcp::ikcp_send(this->kcp_, (const char *)buffer.data(), (int)buffer.size());
+				set_last_error(ret);
+				if (ret == 0)
+					kcp::ikcp_flush(this->kcp_);
+				callback(get_last_error(), ret < 0 ? 0 : buffer.size());
 
 #if defined(ASIO2_SEND_CORE_ASYNC)
-			derive.next_event();
+				derive.next_event();
 #endif
 
-			return (ret == 0);
+				return (ret == 0);
+			}
 		}
 
 		inline void _post_kcp_timer(std::shared_ptr<derived_t> this_ptr)
@@ -131,19 +263,22 @@ namespace asio2::detail
 				std::chrono::milliseconds>(std::chrono::steady_clock::now().time_since_epoch()).count());
 			std::uint32_t clock2 = kcp::ikcp_check(this->kcp_, clock1);
 
-			this->kcp_timer_.expires_after(std::chrono::milliseconds(clock2 - clock1));
-			this->kcp_timer_.async_wait(asio::bind_executor(this->kcp_io_.strand(),
-				make_allocator(this->tallocator_,
-					[this, self_ptr = std::move(this_ptr)](const error_code & ec)
+			// the kcp is started in the io strand, but post it for safety if the caller is not
+			if (!this->kcp_io_.strand().running_in_this_thread())
 			{
-				this->_handle_kcp_timer(ec, std::move(self_ptr));
-			})));
+				asio::post(this->kcp_io_.strand(), [this, this_ptr = std::move(this_ptr)]() mutable
+				{
+					this->_post_kcp_timer(std::move(this_ptr));
+				});
+				return;
+			}
+
+			this->kcp_timer_.self_ = std::move(this_ptr);
+			this->kcp_io_.wheel().schedule(this->kcp_timer_, clock2 - clock1);
 		}
 
-		inline void _handle_kcp_timer(const error_code & ec, std::shared_ptr<derived_t> this_ptr)
+		inline void _handle_kcp_timer(std::shared_ptr<derived_t> this_ptr)
 		{
-			if (ec == asio::error::operation_aborted) return;
-
 			std::uint32_t clock = static_cast<std::uint32_t>(std::chrono::duration_cast<
 				std::chrono::milliseconds>(std::chrono::steady_clock::now().time_since_epoch()).count());
 			kcp::ikcp_update(this->kcp_, clock);
@@ -154,7 +289,21 @@ namespace asio2::detail
 		template<class buffer_t>
 		inline void _kcp_recv(std::shared_ptr<derived_t>& this_ptr, std::string_view s, buffer_t& buffer)
 		{
-			int len = kcp::ikcp_input(this->kcp_, (const char *)s.data(), (long)s.size());
+			int len = 0;
+			if (this->fec_)
+			{
+				// the lost kcp packets may be recovered, they are input after the received one
+				if (!this->fec_->decode(s, [this, &len](std::string_view packet)
+				{
+					if (kcp::ikcp_input(this->kcp_, packet.data(), (long)packet.size()) != 0)
+						len = -1;
+				}))
+					len = -1;
+			}
+			else
+			{
+				len = kcp::ikcp_input(this->kcp_, (const char *)s.data(), (long)s.size());
+			}
 			buffer.consume(buffer.size());
 			if (len != 0)
 			{
@@ -164,20 +313,35 @@ namespace asio2::detail
 			}
 			for (;;)
 			{
-				len = kcp::ikcp_recv(this->kcp_, (char *)buffer.prepare(
-					buffer.pre_size()).data(), (int)buffer.pre_size());
-				if /**/ (len >= 0)
+				// the size of the next complete message, it's negative if there is none
+				len = kcp::ikcp_peeksize(this->kcp_);
+				if (len < 0)
+					break;
+
+				const kcp::IKCPSEG * seg = kcp::front_segment(this->kcp_);
+
+				// the message is not fragmented, deliver the data of the segment directly, then
+				// pop the segment without copying by passing a null buffer to the ikcp_recv.
+				if (seg->frg == 0)
 				{
-					buffer.commit(len);
-					derive._fire_recv(this_ptr, std::string_view(static_cast
-						<std::string_view::const_pointer>(buffer.data().data()), len));
-					buffer.consume(len);
+					derive._fire_recv(this_ptr, std::string_view(seg->data, seg->len));
+					kcp::ikcp_recv(this->kcp_, nullptr, len);
+					continue;
 				}
-				else if (len == -3)
+
+				// the fragments are merged into the buffer which is sized once by the peeked size
+				if (static_cast<std::size_t>(len) > buffer.max_size())
 				{
-					buffer.pre_size(buffer.pre_size() * 2);
+					set_last_error(asio::error::message_size);
+					derive._do_disconnect(asio::error::message_size);
+					return;
 				}
-				else break;
+
+				len = kcp::ikcp_recv(this->kcp_, (char *)buffer.prepare(len).data(), len);
+				buffer.commit(len);
+				derive._fire_recv(this_ptr, std::string_view(static_cast
+					<std::string_view::const_pointer>(buffer.data().data()), len));
+				buffer.consume(len);
 			}
 			kcp::ikcp_flush(this->kcp_);
 		}
@@ -198,7 +362,15 @@ namespace asio2::detail
 					std::uint32_t conv = fnv1a_hash<std::uint32_t>(
 						(const unsigned char * const)&key, std::uint32_t(sizeof(key)));
 					this->seq_ = conv;
-					kcp::kcphdr synack = kcp::make_kcphdr_synack(this->seq_, hdr->th_seq);
+
+					// the shards requested by the client are accepted if the fec of the server is enabled
+					const kcp_config & config = derive.kcp_config_;
+					if (config.fec_data > 0 && config.fec_parity > 0)
+						this->_kcp_fec(hdr->th_fec_data, hdr->th_fec_parity);
+					else
+						this->_kcp_fec(0, 0);
+
+					kcp::kcphdr synack = this->_kcp_synack(hdr->th_seq);
 					this->_kcp_send_hdr(synack, ec);
 					asio::detail::throw_error(ec);
 
@@ -210,7 +382,10 @@ namespace asio2::detail
 					// step 1 : client send syn to server
 					this->seq_ = static_cast<std::uint32_t>(std::chrono::duration_cast<std::chrono::milliseconds>(
 						std::chrono::system_clock::now().time_since_epoch()).count());
-					kcp::kcphdr syn = kcp::make_kcphdr_syn(this->seq_);
+					const kcp_config & config = derive.kcp_config_;
+					kcp::kcphdr syn = kcp::make_kcphdr_syn(this->seq_,
+						static_cast<std::uint16_t>((std::clamp)(config.fec_data  , 0, int(kcp_fec::max_shards))),
+						static_cast<std::uint16_t>((std::clamp)(config.fec_parity, 0, int(kcp_fec::max_shards))));
 					this->_kcp_send_hdr(syn, ec);
 					asio::detail::throw_error(ec);
 
@@ -256,7 +431,9 @@ namespace asio2::detail
 						// Check whether the data is the correct handshake information
 						if (kcp::is_kcphdr_synack(s, this->seq_))
 						{
-							std::uint32_t conv = ((kcp::kcphdr*)(s.data()))->th_seq;
+							kcp::kcphdr * hdr = (kcp::kcphdr*)(s.data());
+							std::uint32_t conv = hdr->th_seq;
+							this->_kcp_fec(hdr->th_fec_data, hdr->th_fec_parity);
 							this->_kcp_start(this_ptr, conv);
 							this->_handle_handshake(ec, std::move(this_ptr), condition);
 						}
@@ -312,14 +489,18 @@ namespace asio2::detail
 
 			kcp_stream_cp * zhis = ((kcp_stream_cp*)user);
 
-			derived_t & derive = zhis->derive;
-
 			error_code ec;
-			if constexpr (isSession)
-				derive.stream().send_to(asio::buffer(buf, len),
-					derive.remote_endpoint_, 0, ec);
+			if (zhis->fec_)
+			{
+				zhis->fec_->encode(buf, static_cast<std::size_t>(len), [zhis, &ec](const char * data, std::size_t size)
+				{
+					zhis->_kcp_send_raw(data, size, ec);
+				});
+			}
 			else
-				derive.stream().send(asio::buffer(buf, len), 0, ec);
+			{
+				zhis->_kcp_send_raw(buf, static_cast<std::size_t>(len), ec);
+			}
 
 			return 0;
 		}
@@ -335,9 +516,10 @@ namespace asio2::detail
 
 		bool                          send_fin_ = true;
 
-		handler_memory<>              tallocator_;
+		kcp_timer_node                kcp_timer_;
 
-		asio::steady_timer            kcp_timer_;
+		/// the reed-solomon fec, it's null if the fec is not negotiated
+		std::unique_ptr<kcp_fec>      fec_;
 	};
 }
 
@@ -34,6 +34,7 @@
 #include <asio2/base/detail/buffer_wrap.hpp>
 
 #include <asio2/base/component/data_persistence_cp.hpp>
+#include <asio2/base/component/event_queue_cp.hpp>
 
 namespace asio2::detail
 {
@@ -375,13 +376,8 @@ namespace asio2::detail
 				if (!this->derive.is_started())
 					asio::detail::throw_error(asio::error::not_connected);
 
-				this->derive.push_event([this,
-					endpoint = std::forward<Endpoint>(endpoint),
-					data = this->derive._data_persistence(std::forward<T>(data))]() mutable
-				{
-					return this->derive._do_send(endpoint, data, [](const error_code&, std::size_t) {});
-				});
-				return true;
+				return this->_push_send_to(std::forward<Endpoint>(endpoint),
+					this->derive._data_persistence(std::forward<T>(data)), [](const error_code&, std::size_t) {});
 			}
 			catch (system_error & e) { set_last_error(e); }
 			catch (std::exception &) { set_last_error(asio::error::eof); }
@@ -431,13 +427,8 @@ namespace asio2::detail
 				if (!s)
 					asio::detail::throw_error(asio::error::invalid_argument);
 
-				this->derive.push_event([this,
-					endpoint = std::forward<Endpoint>(endpoint),
-					data = this->derive._data_persistence(s, count)]() mutable
-				{
-					return this->derive._do_send(endpoint, data, [](const error_code&, std::size_t) {});
-				});
-				return true;
+				return this->_push_send_to(std::forward<Endpoint>(endpoint),
+					this->derive._data_persistence(s, count), [](const error_code&, std::size_t) {});
 			}
 			catch (system_error & e) { set_last_error(e); }
 			catch (std::exception &) { set_last_error(asio::error::eof); }
@@ -471,14 +462,10 @@ namespace asio2::detail
 				if (!this->derive.is_started())
 					asio::detail::throw_error(asio::error::not_connected);
 
-				this->derive.push_event([this, endpoint = std::forward<Endpoint>(endpoint),
-					data = this->derive._data_persistence(std::forward<T>(data)),
-					promise = std::move(promise)]() mutable
+				this->_push_send_to(std::forward<Endpoint>(endpoint), this->derive._data_persistence(std::forward<T>(data)),
+					[promise = std::move(promise)](const error_code& ec, std::size_t bytes_sent) mutable
 				{
-					return this->derive._do_send(endpoint, data, [&promise](const error_code& ec, std::size_t bytes_sent)
-					{
-						promise().set_value(std::pair<error_code, std::size_t>(ec, bytes_sent));
-					});
+					promise().set_value(std::pair<error_code, std::size_t>(ec, bytes_sent));
 				});
 			}
 			catch (system_error & e)
@@ -540,14 +527,10 @@ namespace asio2::detail
 				if (!s)
 					asio::detail::throw_error(asio::error::invalid_argument);
 
-				this->derive.push_event([this, endpoint = std::forward<Endpoint>(endpoint),
-					data = this->derive._data_persistence(s, count),
-					promise = std::move(promise)]() mutable
+				this->_push_send_to(std::forward<Endpoint>(endpoint), this->derive._data_persistence(s, count),
+					[promise = std::move(promise)](const error_code& ec, std::size_t bytes_sent) mutable
 				{
-					return this->derive._do_send(endpoint, data, [&promise](const error_code& ec, std::size_t bytes_sent)
-					{
-						promise().set_value(std::pair<error_code, std::size_t>(ec, bytes_sent));
-					});
+					promise().set_value(std::pair<error_code, std::size_t>(ec, bytes_sent));
 				});
 			}
 			catch (system_error & e)
@@ -589,16 +572,11 @@ namespace asio2::detail
 				if (!this->derive.is_started())
 					asio::detail::throw_error(asio::error::not_connected);
 
-				this->derive.push_event([this, endpoint = std::forward<Endpoint>(endpoint),
-					data = this->derive._data_persistence(std::forward<T>(data)),
-					fn = std::forward<Callback>(fn)]() mutable
+				return this->_push_send_to(std::forward<Endpoint>(endpoint), this->derive._data_persistence(std::forward<T>(data)),
+					[fn = std::forward<Callback>(fn)](const error_code&, std::size_t bytes_sent) mutable
 				{
-					return this->derive._do_send(endpoint, data, [&fn](const error_code&, std::size_t bytes_sent)
-					{
-						callback_helper::call(fn, bytes_sent);
-					});
+					callback_helper::call(fn, bytes_sent);
 				});
-				return true;
 			}
 			catch (system_error & e) { set_last_error(e); }
 			catch (std::exception &) { set_last_error(asio::error::eof); }
@@ -651,16 +629,11 @@ namespace asio2::detail
 				if (!s)
 					asio::detail::throw_error(asio::error::invalid_argument);
 
-				this->derive.push_event([this, endpoint = std::forward<Endpoint>(endpoint),
-					data = this->derive._data_persistence(s, count),
-					fn = std::forward<Callback>(fn)]() mutable
+				return this->_push_send_to(std::forward<Endpoint>(endpoint), this->derive._data_persistence(s, count),
+					[fn = std::forward<Callback>(fn)](const error_code&, std::size_t bytes_sent) mutable
 				{
-					return this->derive._do_send(endpoint, data, [&fn](const error_code&, std::size_t bytes_sent)
-					{
-						callback_helper::call(fn, bytes_sent);
-					});
+					callback_helper::call(fn, bytes_sent);
 				});
-				return true;
 			}
 			catch (system_error & e) { set_last_error(e); }
 			catch (std::exception &) { set_last_error(asio::error::eof); }
@@ -700,18 +673,78 @@ namespace asio2::detail
 					decltype(endpoints.size()) i = 1;
 					for (auto iter = endpoints.begin(); iter != endpoints.end(); ++iter, ++i)
 					{
-						this->derive.push_event([this, endpoint = iter->endpoint(),
-							data = (endpoints.size() == i ? std::move(data) : data),
-							callback = (endpoints.size() == i ? std::move(callback) : callback)
-						]() mutable
-						{
-							return this->derive._do_send(endpoint, data, std::move(callback));
-						});
+						this->_push_send_to(iter->endpoint(),
+							(endpoints.size() == i ? std::move(data) : data),
+							(endpoints.size() == i ? std::move(callback) : callback));
 					}
 				}
 			}));
 			return true;
 		}
+
+		/**
+		 * the queued send event with the destination endpoint, the data of the queued sends can be
+		 * gathered by the executing send to send them in a batch.
+		 */
+		template<class Data, class Callback>
+		class send_to_event final : public event_base
+		{
+		public:
+			template<class E, class D, class C>
+			send_to_event(derived_t& d, E&& endpoint, D&& data, C&& callback)
+				: derive(d), endpoint_(std::forward<E>(endpoint))
+				, data_(std::forward<D>(data)), callback_(std::forward<C>(callback))
+			{
+				size_ = asio::buffer_size(to_buffers(data_));
+			}
+
+			virtual bool operator()() override
+			{
+				return derive._do_send(endpoint_, data_, [this](const error_code& ec, std::size_t bytes_sent)
+				{
+					callback_(ec, bytes_sent);
+				});
+			}
+
+			virtual bool gather(std::vector<asio::const_buffer>& buffers) override
+			{
+				auto&& b = to_buffers(data_);
+				buffers.insert(buffers.end(), asio::buffer_sequence_begin(b), asio::buffer_sequence_end(b));
+				return true;
+			}
+
+			virtual void complete(const error_code& ec, std::size_t bytes_sent) override
+			{
+				callback_(ec, bytes_sent);
+			}
+
+			virtual bool is_send() const override { return true; }
+
+			virtual std::size_t size() const override { return size_; }
+
+			virtual const asio::ip::udp::endpoint * endpoint() const override { return &endpoint_; }
+
+		protected:
+			derived_t             & derive;
+			asio::ip::udp::endpoint endpoint_;
+			Data                    data_;
+			Callback                callback_;
+			std::size_t             size_ = 0;
+		};
+
+		/**
+		 * return false if the send is dropped by the send policy, the callback is called with
+		 * error no_buffer_space in this case.
+		 */
+		template<class Endpoint, class Data, class Callback>
+		inline bool _push_send_to(Endpoint&& endpoint, Data&& data, Callback&& callback)
+		{
+			using data_type     = std::remove_cv_t<std::remove_reference_t<Data>>;
+			using callback_type = std::remove_cv_t<std::remove_reference_t<Callback>>;
+
+			return this->derive._push_send_event(std::unique_ptr<event_base>(new send_to_event<data_type, callback_type>(
+				this->derive, std::forward<Endpoint>(endpoint), std::forward<Data>(data), std::forward<Callback>(callback))));
+		}
 	};
 }
 
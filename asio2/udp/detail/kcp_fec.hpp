@@ -0,0 +1,513 @@
+/*
+ * COPYRIGHT (C) 2017-2019, zhllxt
+ *
+ * author   : zhllxt
+ * email    : 37792738@qq.com
+ *
+ * Distributed under the GNU GENERAL PUBLIC LICENSE Version 3, 29 June 2007
+ * (See accompanying file LICENSE or see <http://www.gnu.org/licenses/>)
+ */
+
+#ifndef __ASIO2_KCP_FEC_HPP__
+#define __ASIO2_KCP_FEC_HPP__
+
+#if defined(_MSC_VER) && (_MSC_VER >= 1200)
+#pragma once
+#endif // defined(_MSC_VER) && (_MSC_VER >= 1200)
+
+#include <cstdint>
+#include <cstring>
+#include <array>
+#include <vector>
+#include <algorithm>
+#include <string_view>
+
+namespace asio2::detail
+{
+	/**
+	 * the arithmetic of the galois field GF(2^8), the polynomial is x^8 + x^4 + x^3 + x^2 + 1
+	 */
+	class gf256
+	{
+	public:
+		/**
+		 * @function : get the tables, they are built once
+		 */
+		static inline const gf256 & instance()
+		{
+			static gf256 g;
+			return g;
+		}
+
+		inline std::uint8_t mul(std::uint8_t a, std::uint8_t b) const { return this->mul_[a][b]; }
+
+		inline std::uint8_t inv(std::uint8_t a) const { return this->inv_[a]; }
+
+		/**
+		 * @function : dst[i] ^= c * src[i]
+		 */
+		inline void mul_add(std::uint8_t c, const char * src, char * dst, std::size_t n) const
+		{
+			if (c == 0)
+				return;
+
+			const std::uint8_t * row = this->mul_[c].data();
+			const std::uint8_t * s = reinterpret_cast<const std::uint8_t *>(src);
+			std::uint8_t * d = reinterpret_cast<std::uint8_t *>(dst);
+
+			for (std::size_t i = 0; i < n; ++i)
+				d[i] ^= row[s[i]];
+		}
+
+	protected:
+		gf256()
+		{
+			std::array<std::uint8_t, 512> exp{};
+			std::array<std::uint8_t, 256> log{};
+
+			unsigned int x = 1;
+			for (unsigned int i = 0; i < 255; ++i)
+			{
+				exp[i] = static_cast<std::uint8_t>(x);
+				log[x] = static_cast<std::uint8_t>(i);
+				x <<= 1;
+				if (x & 0x100)
+					x ^= 0x11d;
+			}
+			for (unsigned int i = 255; i < 512; ++i)
+				exp[i] = exp[i - 255];
+
+			for (unsigned int a = 0; a < 256; ++a)
+			{
+				for (unsigned int b = 0; b < 256; ++b)
+					this->mul_[a][b] = (a && b) ? exp[log[a] + log[b]] : 0;
+
+				this->inv_[a] = a ? exp[255 - log[a]] : 0;
+			}
+		}
+
+	protected:
+		std::array<std::array<std::uint8_t, 256>, 256> mul_;
+
+		std::array<std::uint8_t, 256>                  inv_;
+	};
+
+	/**
+	 * the reed-solomon forward error correction of the kcp datagrams, each group has data shards
+	 * which are sent immediately, and parity shards which are sent when the data shards of the group
+	 * are complete. the receiver recovers the lost data shards of a group as soon as the count of the
+	 * received shards of it reaches the count of the data shards. the parity rows are a cauchy matrix,
+	 * so any data_shards rows of the systematic matrix are invertible.
+	 *
+	 * the datagram : | seq (4) | type (2) | data shard : size (2) + the kcp packet, or parity |
+	 * the integers are little endian, the data shards are padded with zeros to the length of the
+	 * longest one of the group when the parity is calculated.
+	 */
+	class kcp_fec
+	{
+	public:
+		/// the size of the seq and type
+		static constexpr std::size_t   header_size = 6;
+
+		/// the bytes which are added to the kcp packet
+		static constexpr std::size_t   overhead    = header_size + 2;
+
+		/// the max count of the data shards or the parity shards, it's limited by the kcphdr bits
+		static constexpr std::size_t   max_shards  = 31;
+
+		static constexpr std::uint16_t type_data   = 0xf1;
+		static constexpr std::uint16_t type_parity = 0xf2;
+
+		/**
+		 * @constructor
+		 * @param : mtu - the max size of the datagram, the kcp mtu must be less than it by overhead.
+		 */
+		kcp_fec(std::size_t data, std::size_t parity, std::size_t mtu)
+			: gf_(gf256::instance())
+			, data_  ((std::clamp)(data  , std::size_t(1), max_shards))
+			, parity_((std::clamp)(parity, std::size_t(1), max_shards))
+			, total_(data_ + parity_)
+			, mtu_((std::max)(mtu, overhead + 1))
+			, shard_size_(mtu_ - header_size)
+			, stride_((shard_size_ + 2 + 7) & ~std::size_t(7))
+			, wrap_(static_cast<std::uint32_t>((std::uint64_t(0xffffffff) / total_) * total_))
+		{
+			this->matrix_.resize(this->parity_ * this->data_);
+			for (std::size_t i = 0; i < this->parity_; ++i)
+				for (std::size_t j = 0; j < this->data_; ++j)
+					this->matrix_[i * this->data_ + j] = this->gf_.inv(
+						static_cast<std::uint8_t>((this->data_ + i) ^ j));
+
+			this->encoder_.resize(this->total_ * this->mtu_);
+			this->lengths_.assign(this->data_, 0);
+
+			for (group & g : this->groups_)
+			{
+				g.shards.resize(this->total_ * this->stride_ + 8);
+				g.lengths.assign(this->total_, 0);
+			}
+
+			this->square_.resize(this->data_ * this->data_);
+			this->inverse_.resize(this->data_ * this->data_);
+			this->rows_.resize(this->data_);
+		}
+
+		/**
+		 * @function : get the count of the data shards
+		 */
+		inline std::size_t data_shards() const { return this->data_; }
+
+		/**
+		 * @function : get the count of the parity shards
+		 */
+		inline std::size_t parity_shards() const { return this->parity_; }
+
+		/**
+		 * @function : get the max size of the datagram
+		 */
+		inline std::size_t mtu() const { return this->mtu_; }
+
+		/**
+		 * @function : wrap the kcp packet to a data shard and send it, send the parity shards too
+		 * if the data shards of the group are complete.
+		 * Sender signature : void(const char * data, std::size_t size)
+		 */
+		template<class Sender>
+		inline void encode(const char * buf, std::size_t len, Sender&& send)
+		{
+			len = (std::min)(len, this->mtu_ - overhead);
+
+			char * slot = this->encoder_.data() + this->index_ * this->mtu_;
+
+			this->_write_header(slot, this->seq_, type_data);
+			_write16(slot + header_size, static_cast<std::uint16_t>(len));
+			std::memcpy(slot + overhead, buf, len);
+
+			this->seq_ = this->_next_seq(this->seq_);
+
+			send(const_cast<const char *>(slot), overhead + len);
+
+			this->lengths_[this->index_] = len + 2;
+
+			if (++(this->index_) < this->data_)
+				return;
+
+			this->index_ = 0;
+
+			std::size_t length = *std::max_element(this->lengths_.begin(), this->lengths_.end());
+
+			for (std::size_t j = 0; j < this->data_; ++j)
+			{
+				char * shard = this->encoder_.data() + j * this->mtu_ + header_size;
+				std::memset(shard + this->lengths_[j], 0, length - this->lengths_[j]);
+			}
+
+			for (std::size_t i = 0; i < this->parity_; ++i)
+			{
+				char * p = this->encoder_.data() + (this->data_ + i) * this->mtu_;
+
+				this->_write_header(p, this->seq_, type_parity);
+				this->seq_ = this->_next_seq(this->seq_);
+
+				std::memset(p + header_size, 0, length);
+				for (std::size_t j = 0; j < this->data_; ++j)
+				{
+					this->gf_.mul_add(this->matrix_[i * this->data_ + j],
+						this->encoder_.data() + j * this->mtu_ + header_size, p + header_size, length);
+				}
+
+				send(const_cast<const char *>(p), header_size + length);
+			}
+		}
+
+		/**
+		 * @function : parse the datagram, the kcp packet of the data shard is passed to the receiver
+		 * directly, and the kcp packets which are recovered by the parity shards are passed too.
+		 * return false if the datagram is not a fec datagram.
+		 * Receiver signature : void(std::string_view packet)
+		 */
+		template<class Receiver>
+		inline bool decode(std::string_view s, Receiver&& recv)
+		{
+			if (s.size() < header_size)
+				return false;
+
+			std::uint32_t seq  = _read32(s.data());
+			std::uint16_t type = _read16(s.data() + 4);
+
+			if /**/ (type == type_data)
+			{
+				if (s.size() < overhead)
+					return false;
+
+				std::size_t size = _read16(s.data() + header_size);
+				if (size > s.size() - overhead)
+					return false;
+
+				recv(s.substr(overhead, size));
+			}
+			else if (type != type_parity)
+			{
+				return false;
+			}
+
+			std::size_t length = s.size() - header_size;
+			if (length > this->shard_size_)
+				return true;
+
+			std::uint32_t id = seq / static_cast<std::uint32_t>(this->total_);
+			std::size_t index = seq % this->total_;
+
+			group & g = this->groups_[id % this->groups_.size()];
+
+			// the slot is reused by the newer group, the shards of the older group are discarded
+			if (!g.used || g.id != id)
+			{
+				g.id = id;
+				g.used = true;
+				g.done = false;
+				g.count = 0;
+				g.data_count = 0;
+				std::fill(g.lengths.begin(), g.lengths.end(), 0);
+			}
+
+			if (g.done || g.lengths[index] != 0)
+				return true;
+
+			std::memcpy(this->_shard(g, index), s.data() + header_size, length);
+
+			g.lengths[index] = length;
+
+			++(g.count);
+
+			if (index < this->data_)
+				++(g.data_count);
+
+			if (g.data_count == this->data_)
+			{
+				g.done = true;
+			}
+			else if (g.count >= this->data_)
+			{
+				g.done = true;
+				this->_recover(g, recv);
+			}
+
+			return true;
+		}
+
+	protected:
+		struct group
+		{
+			std::uint32_t            id         = 0;
+			bool                     used       = false;
+			bool                     done       = false;
+			std::size_t              count      = 0;
+			std::size_t              data_count = 0;
+
+			/// the received shards, the length of the shard which isn't received is 0
+			std::vector<char>        shards;
+			std::vector<std::size_t> lengths;
+		};
+
+		template<class Receiver>
+		inline void _recover(group & g, Receiver& recv)
+		{
+			// all the parity shards have the same length
+			std::size_t length = 0;
+			for (std::size_t i = this->data_; i < this->total_; ++i)
+				length = (std::max)(length, g.lengths[i]);
+
+			if (length < 2)
+				return;
+
+			// choose the rows of the received shards, data shards first
+			std::size_t n = 0;
+			for (std::size_t i = 0; i < this->total_ && n < this->data_; ++i)
+			{
+				if (g.lengths[i] == 0)
+					continue;
+
+				this->rows_[n] = i;
+
+				std::uint8_t * row = this->square_.data() + n * this->data_;
+				if (i < this->data_)
+				{
+					std::fill(row, row + this->data_, std::uint8_t(0));
+					row[i] = 1;
+				}
+				else
+				{
+					std::copy_n(this->matrix_.data() + (i - this->data_) * this->data_, this->data_, row);
+				}
+
+				char * shard = this->_shard(g, i);
+				if (g.lengths[i] < length)
+					std::memset(shard + g.lengths[i], 0, length - g.lengths[i]);
+
+				++n;
+			}
+
+			if (!this->_invert())
+				return;
+
+			for (std::size_t j = 0; j < this->data_; ++j)
+			{
+				if (g.lengths[j] != 0)
+					continue;
+
+				char * out = this->_shard(g, j);
+				std::memset(out, 0, length);
+
+				for (std::size_t r = 0; r < this->data_; ++r)
+				{
+					this->gf_.mul_add(this->inverse_[j * this->data_ + r],
+						this->_shard(g, this->rows_[r]), out, length);
+				}
+
+				std::size_t size = _read16(out);
+				if (size <= length - 2)
+					recv(std::string_view(out + 2, size));
+			}
+		}
+
+		/**
+		 * the shards are 6 bytes after an aligned address, so the kcp packets after the size of the
+		 * data shards are 8 bytes aligned, the ikcp decodes the header by the integer pointers.
+		 */
+		inline char * _shard(group & g, std::size_t i) const
+		{
+			return g.shards.data() + i * this->stride_ + 6;
+		}
+
+		/**
+		 * invert the square_ to the inverse_ by the gauss-jordan elimination
+		 */
+		inline bool _invert()
+		{
+			std::size_t n = this->data_;
+			std::uint8_t * a = this->square_.data();
+			std::uint8_t * b = this->inverse_.data();
+
+			std::fill(this->inverse_.begin(), this->inverse_.end(), std::uint8_t(0));
+			for (std::size_t i = 0; i < n; ++i)
+				b[i * n + i] = 1;
+
+			for (std::size_t c = 0; c < n; ++c)
+			{
+				std::size_t p = c;
+				while (p < n && a[p * n + c] == 0)
+					++p;
+				if (p == n)
+					return false;
+
+				if (p != c)
+				{
+					std::swap_ranges(a + p * n, a + p * n + n, a + c * n);
+					std::swap_ranges(b + p * n, b + p * n + n, b + c * n);
+				}
+
+				std::uint8_t f = this->gf_.inv(a[c * n + c]);
+				for (std::size_t k = 0; k < n; ++k)
+				{
+					a[c * n + k] = this->gf_.mul(a[c * n + k], f);
+					b[c * n + k] = this->gf_.mul(b[c * n + k], f);
+				}
+
+				for (std::size_t r = 0; r < n; ++r)
+				{
+					std::uint8_t e = a[r * n + c];
+					if (r == c || e == 0)
+						continue;
+					for (std::size_t k = 0; k < n; ++k)
+					{
+						a[r * n + k] ^= this->gf_.mul(a[c * n + k], e);
+						b[r * n + k] ^= this->gf_.mul(b[c * n + k], e);
+					}
+				}
+			}
+
+			return true;
+		}
+
+		/// the seq wraps at a multiple of the group size, so the seq / total is always the group
+		inline std::uint32_t _next_seq(std::uint32_t seq) const
+		{
+			return (seq + 1 == this->wrap_) ? 0 : seq + 1;
+		}
+
+		inline void _write_header(char * p, std::uint32_t seq, std::uint16_t type)
+		{
+			_write32(p, seq);
+			_write16(p + 4, type);
+		}
+
+		static inline void _write16(char * p, std::uint16_t v)
+		{
+			p[0] = static_cast<char>(v & 0xff);
+			p[1] = static_cast<char>(v >> 8);
+		}
+
+		static inline void _write32(char * p, std::uint32_t v)
+		{
+			_write16(p, static_cast<std::uint16_t>(v & 0xffff));
+			_write16(p + 2, static_cast<std::uint16_t>(v >> 16));
+		}
+
+		static inline std::uint16_t _read16(const char * p)
+		{
+			const std::uint8_t * u = reinterpret_cast<const std::uint8_t *>(p);
+			return static_cast<std::uint16_t>(u[0] | (u[1] << 8));
+		}
+
+		static inline std::uint32_t _read32(const char * p)
+		{
+			return std::uint32_t(_read16(p)) | (std::uint32_t(_read16(p + 2)) << 16);
+		}
+
+	protected:
+		const gf256                & gf_;
+
+		std::size_t                  data_;
+
+		std::size_t                  parity_;
+
+		std::size_t                  total_;
+
+		/// the max size of the datagram
+		std::size_t                  mtu_;
+
+		/// the max size of a shard without the header
+		std::size_t                  shard_size_;
+
+		/// the distance of the shards in the decoding buffer, it's a multiple of 8
+		std::size_t                  stride_;
+
+		std::uint32_t                wrap_;
+
+		/// the parity rows of the encoding matrix, parity_ x data_
+		std::vector<std::uint8_t>    matrix_;
+
+		/// the datagrams of the current group which is being encoded
+		std::vector<char>            encoder_;
+
+		/// the lengths of the data shards of the current encoding group
+		std::vector<std::size_t>     lengths_;
+
+		/// the index of the next data shard in the current encoding group
+		std::size_t                  index_ = 0;
+
+		std::uint32_t                seq_   = 0;
+
+		/// the groups which are being decoded, the shards may be reordered across the groups
+		std::array<group, 3>         groups_;
+
+		std::vector<std::uint8_t>    square_;
+
+		std::vector<std::uint8_t>    inverse_;
+
+		std::vector<std::size_t>     rows_;
+	};
+}
+
+#endif // !__ASIO2_KCP_FEC_HPP__
@@ -83,7 +83,8 @@ namespace asio2::detail::kcp
 		std::uint16_t thf_rst : 1;
 		std::uint16_t thf_syn : 1;
 		std::uint16_t thf_fin : 1;
-		std::uint16_t th_padding : 10;
+		std::uint16_t th_fec_data : 5;   /* the data shards of the fec, 0 means disable */
+		std::uint16_t th_fec_parity : 5; /* the parity shards of the fec */
 		std::uint16_t th_sum;
 	}__KCPHDR_ONEBYTE_ALIGN__;
 #if defined(__GNUC__) || defined(__GNUG__)
@@ -176,11 +177,13 @@ namespace asio2::detail::kcp
 	}
 
 	template<typename = void>
-	inline kcphdr make_kcphdr_syn(std::uint32_t seq)
+	inline kcphdr make_kcphdr_syn(std::uint32_t seq, std::uint16_t fec_data = 0, std::uint16_t fec_parity = 0)
 	{
 		kcphdr hdr = { 0 };
 		hdr.th_seq = seq;
 		hdr.thf_syn = 1;
+		hdr.th_fec_data = fec_data & 0x1f;
+		hdr.th_fec_parity = fec_parity & 0x1f;
 		hdr.th_sum = checksum(reinterpret_cast<unsigned short *>(&hdr),
 			static_cast<int>(sizeof(kcphdr) - sizeof(kcphdr::th_sum)));
 
@@ -188,13 +191,16 @@ namespace asio2::detail::kcp
 	}
 
 	template<typename = void>
-	inline kcphdr make_kcphdr_synack(std::uint32_t seq, std::uint32_t ack)
+	inline kcphdr make_kcphdr_synack(std::uint32_t seq, std::uint32_t ack,
+		std::uint16_t fec_data = 0, std::uint16_t fec_parity = 0)
 	{
 		kcphdr hdr = { 0 };
 		hdr.th_seq = seq;
 		hdr.th_ack = ack + 1;
 		hdr.thf_ack = 1;
 		hdr.thf_syn = 1;
+		hdr.th_fec_data = fec_data & 0x1f;
+		hdr.th_fec_parity = fec_parity & 0x1f;
 		hdr.th_sum = checksum(reinterpret_cast<unsigned short *>(&hdr),
 			static_cast<int>(sizeof(kcphdr) - sizeof(kcphdr::th_sum)));
 
@@ -225,10 +231,117 @@ namespace asio2::detail::kcp
 		return hdr;
 	}
 
+	/**
+	 * get the first segment of the receive queue, it's the head of the next message which is
+	 * peeked by the ikcp_peeksize, return nullptr if the queue is empty.
+	 */
+	template<typename = void>
+	inline const IKCPSEG * front_segment(const ikcpcb * kcp)
+	{
+		if (iqueue_is_empty(&kcp->rcv_queue))
+			return nullptr;
+		return iqueue_entry(kcp->rcv_queue.next, const IKCPSEG, node);
+	}
+
 	struct kcp_deleter
 	{
 		inline void operator()(ikcpcb* p) const { kcp::ikcp_release(p); };
 	};
 }
 
+namespace asio2::detail
+{
+	/**
+	 * the tuning parameters of the kcp, see ikcp_nodelay, ikcp_wndsize, ikcp_setmtu of the ikcp.h
+	 * the default values are the fast mode : ikcp_nodelay(kcp, 1, 10, 2, 1), window 128/512.
+	 * note : the receive buffer is enlarged to the mtu when the kcp is started, but the mtu should
+	 * not exceed the mtu of the peer, otherwise the datagrams are truncated by the receive buffer
+	 * of the peer. the stream mode must be the same on both sides.
+	 * the mtu, stream, fec_data and fec_parity can only be set before the handshake, the others
+	 * can be changed at any time.
+	 */
+	struct kcp_config
+	{
+		/// 0 : disable(normal rto), 1 : enable(the rto is not doubled on timeout, min rto is 30 ms)
+		int           nodelay  = 1;
+
+		/// the internal update interval in milliseconds, 10 ~ 5000
+		int           interval = 10;
+
+		/// fast resend after the segment is skipped by so many acks, 0 means disable
+		int           resend   = 2;
+
+		/// 0 : normal congestion control, 1 : disable the congestion control
+		int           nc       = 1;
+
+		/// the send window and the receive window in segments
+		int           sndwnd   = 128;
+		int           rcvwnd   = 512;
+
+		/// the max size of the datagram sent by the kcp
+		int           mtu      = 1400;
+
+		/// the min retransmission timeout in milliseconds, 0 means the default of the nodelay mode
+		int           minrto   = 0;
+
+		/// stream mode, the messages are merged and split like tcp, the boundaries are not kept
+		bool          stream   = false;
+
+		/// the data shards and the parity shards of the reed-solomon fec (1 ~ 31), 0 means disable.
+		/// the client requests its shards in the syn, the server accepts them if its fec is enabled,
+		/// then each data shard costs 8 bytes of the mtu, and the parity shards are sent for each
+		/// group of the data shards, a group can lose any parity_shards datagrams without resending.
+		int           fec_data   = 0;
+		int           fec_parity = 0;
+
+		/**
+		 * @function : lowest latency, the lost segment is resent quickly, use more bandwidth
+		 */
+		static inline kcp_config turbo()
+		{
+			kcp_config c;
+			c.nodelay = 1; c.interval = 10; c.resend = 2; c.nc = 1;
+			c.sndwnd = 128; c.rcvwnd = 512; c.minrto = 10;
+			return c;
+		}
+
+		/**
+		 * @function : the behavior of the tcp, the rto is doubled on timeout, congestion control
+		 */
+		static inline kcp_config normal()
+		{
+			kcp_config c;
+			c.nodelay = 0; c.interval = 40; c.resend = 0; c.nc = 0;
+			c.sndwnd = 128; c.rcvwnd = 128;
+			return c;
+		}
+
+		/**
+		 * @function : high throughput for large transfers on the links with big bandwidth-delay
+		 * product, big windows and fewer updates, the socket buffers should be enlarged too,
+		 * otherwise the bursts of the window are dropped by the socket.
+		 */
+		static inline kcp_config bulk()
+		{
+			kcp_config c;
+			c.nodelay = 0; c.interval = 20; c.resend = 2; c.nc = 1;
+			c.sndwnd = 512; c.rcvwnd = 1024;
+			return c;
+		}
+
+		/**
+		 * @function : the max size of the datagram sent by the kcp, the receive buffer must hold it
+		 */
+		inline std::size_t frame_size() const
+		{
+			return static_cast<std::size_t>(mtu > 0 ? mtu : static_cast<int>(kcp::IKCP_MTU_DEF));
+		}
+	};
+}
+
+namespace asio2
+{
+	using kcp_config = detail::kcp_config;
+}
+
 #endif // !__ASIO2_KCP_UTIL_HPP__
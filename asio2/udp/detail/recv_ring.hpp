@@ -0,0 +1,269 @@
+/*
+ * COPYRIGHT (C) 2017-2019, zhllxt
+ *
+ * author   : zhllxt
+ * email    : 37792738@qq.com
+ *
+ * Distributed under the GNU GENERAL PUBLIC LICENSE Version 3, 29 June 2007
+ * (See accompanying file LICENSE or see <http://www.gnu.org/licenses/>)
+ */
+
+#ifndef __ASIO2_UDP_RECV_RING_HPP__
+#define __ASIO2_UDP_RECV_RING_HPP__
+
+#if defined(_MSC_VER) && (_MSC_VER >= 1200)
+#pragma once
+#endif // defined(_MSC_VER) && (_MSC_VER >= 1200)
+
+#include <cstdint>
+#include <cerrno>
+#include <cstring>
+#include <vector>
+#include <algorithm>
+#include <string_view>
+
+#include <asio2/base/selector.hpp>
+#include <asio2/base/error.hpp>
+
+#if defined(__linux__)
+	#include <sys/socket.h>
+	#include <sys/uio.h>
+	#include <netinet/in.h>
+	#include <netinet/udp.h>
+#endif
+
+namespace asio2::detail
+{
+	/**
+	 * the buffer size which can hold the datagrams coalesced by the UDP_GRO
+	 */
+	inline constexpr std::size_t udp_gro_buffer_size = 65535;
+
+	/**
+	 * a ring of datagram buffers, the datagrams which are already arrived are received by one
+	 * recvmmsg call on linux, and by a loop of non-blocking receive_from on the other platforms.
+	 * when the UDP_GRO is enabled, a buffer may contain several datagrams of the same sender, which
+	 * are coalesced by the kernel, use for_each to get them.
+	 */
+	class udp_recv_ring
+	{
+	public:
+		/**
+		 * @constructor
+		 */
+		udp_recv_ring() = default;
+
+		/**
+		 * @destructor
+		 */
+		~udp_recv_ring() = default;
+
+		udp_recv_ring(const udp_recv_ring&) = delete;
+		udp_recv_ring& operator=(const udp_recv_ring&) = delete;
+
+		/**
+		 * @function : enable the UDP_GRO of the socket, return false if it's not supported.
+		 */
+		static inline bool enable_gro(asio::ip::udp::socket & socket)
+		{
+		#if defined(__linux__) && defined(UDP_GRO)
+			error_code ec;
+			socket.set_option(asio::detail::socket_option::boolean<IPPROTO_UDP, UDP_GRO>(true), ec);
+			return (!ec);
+		#else
+			std::ignore = socket;
+			return false;
+		#endif
+		}
+
+		/**
+		 * @function : prepare the socket for the receive. on linux the recvmmsg is called with the
+		 * MSG_DONTWAIT, so the socket is kept in blocking mode, the kcp writes the same socket
+		 * synchronously and must not get would_block. on the other platforms the loop of receive_from
+		 * needs the socket in non-blocking mode.
+		 */
+		static inline void prepare(asio::ip::udp::socket & socket)
+		{
+		#if defined(__linux__)
+			std::ignore = socket;
+		#else
+			socket.non_blocking(true);
+		#endif
+		}
+
+		/**
+		 * @function : allocate count buffers, each buffer can hold a datagram of size bytes, the
+		 * longer datagram is truncated like the general receive. if gro is true, the size should be
+		 * udp_gro_buffer_size, otherwise the coalesced datagrams are truncated.
+		 */
+		inline void reset(std::size_t count, std::size_t size, bool gro = false)
+		{
+			this->count_ = (std::max)(count, std::size_t(1));
+			this->size_  = (std::max)(size , std::size_t(1));
+			this->gro_   = gro;
+
+			this->storage_.resize(this->count_ * this->size_);
+			this->endpoints_.resize(this->count_);
+			this->sizes_.assign(this->count_, 0);
+			this->segments_.assign(this->count_, 0);
+
+		#if defined(__linux__)
+			this->iovecs_.resize(this->count_);
+			this->headers_.resize(this->count_);
+			this->controls_.assign(this->gro_ ? this->count_ * control_words : 0, 0);
+
+			for (std::size_t i = 0; i < this->count_; ++i)
+			{
+				this->iovecs_[i].iov_base = this->storage_.data() + i * this->size_;
+				this->iovecs_[i].iov_len  = this->size_;
+
+				this->headers_[i] = {};
+				this->headers_[i].msg_hdr.msg_iov    = &(this->iovecs_[i]);
+				this->headers_[i].msg_hdr.msg_iovlen = 1;
+			}
+		#endif
+		}
+
+		/**
+		 * @function : the max number of the datagrams received by one call
+		 */
+		inline std::size_t capacity() const { return this->count_; }
+
+		/**
+		 * @function : receive the datagrams which are already arrived without blocking, return the
+		 * number of the received datagrams, the ec is would_block if there is no datagram.
+		 * on the platforms other than linux, the socket must be prepared by prepare().
+		 */
+		inline std::size_t receive(asio::ip::udp::socket & socket, error_code & ec)
+		{
+		#if defined(__linux__)
+			for (std::size_t i = 0; i < this->count_; ++i)
+			{
+				this->headers_[i].msg_hdr.msg_name    = this->endpoints_[i].data();
+				this->headers_[i].msg_hdr.msg_namelen = static_cast<socklen_t>(this->endpoints_[i].capacity());
+				this->headers_[i].msg_hdr.msg_flags   = 0;
+				this->headers_[i].msg_len             = 0;
+
+				if (this->gro_)
+				{
+					this->headers_[i].msg_hdr.msg_control    = this->controls_.data() + i * control_words;
+					this->headers_[i].msg_hdr.msg_controllen = control_words * sizeof(std::uint64_t);
+				}
+			}
+
+			int n = ::recvmmsg(socket.native_handle(), this->headers_.data(),
+				static_cast<unsigned int>(this->count_), MSG_DONTWAIT, nullptr);
+			if (n < 0)
+			{
+				ec.assign(errno, asio::error::get_system_category());
+				return 0;
+			}
+
+			for (int i = 0; i < n; ++i)
+			{
+				this->endpoints_[i].resize(this->headers_[i].msg_hdr.msg_namelen);
+				this->sizes_[i] = (std::min)(std::size_t(this->headers_[i].msg_len), this->size_);
+				this->segments_[i] = this->sizes_[i];
+
+				if (this->gro_)
+				{
+					struct msghdr & h = this->headers_[i].msg_hdr;
+					for (struct cmsghdr * c = CMSG_FIRSTHDR(&h); c; c = CMSG_NXTHDR(&h, c))
+					{
+						if (c->cmsg_level == IPPROTO_UDP && c->cmsg_type == UDP_GRO)
+						{
+							int segment = 0;
+							std::memcpy(&segment, CMSG_DATA(c), sizeof(int));
+							if (segment > 0)
+								this->segments_[i] = static_cast<std::size_t>(segment);
+						}
+					}
+				}
+			}
+
+			ec.clear();
+			return static_cast<std::size_t>(n);
+		#else
+			std::size_t n = 0;
+			for (; n < this->count_; ++n)
+			{
+				this->sizes_[n] = socket.receive_from(asio::buffer(this->storage_.data() + n * this->size_,
+					this->size_), this->endpoints_[n], 0, ec);
+				if (ec)
+					break;
+				this->segments_[n] = this->sizes_[n];
+			}
+			// the error after some datagrams are received will occur again at the next call
+			if (n > 0)
+				ec.clear();
+			return n;
+		#endif
+		}
+
+		/**
+		 * @function : get the data of the received datagram i
+		 */
+		inline std::string_view data(std::size_t i) const
+		{
+			return std::string_view(this->storage_.data() + i * this->size_, this->sizes_[i]);
+		}
+
+		/**
+		 * @function : call the function for each datagram of the received buffer i, the buffer is
+		 * split by the segment size which is reported by the UDP_GRO.
+		 * Function signature : void(std::string_view s)
+		 */
+		template<class Function>
+		inline void for_each(std::size_t i, Function&& f) const
+		{
+			std::string_view s = this->data(i);
+			std::size_t segment = this->segments_[i];
+
+			if (segment == 0 || segment >= s.size())
+				return f(s);
+
+			for (std::size_t pos = 0; pos < s.size(); pos += segment)
+				f(s.substr(pos, segment));
+		}
+
+		/**
+		 * @function : get the sender of the received datagram i
+		 */
+		inline const asio::ip::udp::endpoint & endpoint(std::size_t i) const
+		{
+			return this->endpoints_[i];
+		}
+
+	protected:
+	#if defined(__linux__)
+		/// the control buffer size of each message in words, the UDP_GRO cmsg carries an int
+		static constexpr std::size_t control_words = (CMSG_SPACE(sizeof(int)) + sizeof(std::uint64_t) - 1) /
+			sizeof(std::uint64_t);
+	#endif
+
+		std::size_t                          count_ = 0;
+
+		std::size_t                          size_  = 0;
+
+		std::vector<char>                    storage_;
+
+		std::vector<asio::ip::udp::endpoint> endpoints_;
+
+		std::vector<std::size_t>             sizes_;
+
+		/// the segment size of each buffer, it's less than the size if the datagrams are coalesced
+		std::vector<std::size_t>             segments_;
+
+		bool                                 gro_ = false;
+
+	#if defined(__linux__)
+		std::vector<struct iovec>            iovecs_;
+
+		std::vector<struct mmsghdr>          headers_;
+
+		std::vector<std::uint64_t>           controls_;
+	#endif
+	};
+}
+
+#endif // !__ASIO2_UDP_RECV_RING_HPP__
@@ -15,6 +15,7 @@
 #pragma once
 #endif // defined(_MSC_VER) && (_MSC_VER >= 1200)
 
+#include <cstring>
 #include <memory>
 #include <future>
 #include <utility>
@@ -23,6 +24,16 @@
 #include <asio2/base/selector.hpp>
 #include <asio2/base/error.hpp>
 #include <asio2/base/detail/condition_wrap.hpp>
+#include <asio2/base/detail/buffer_wrap.hpp>
+
+#include <asio2/base/component/event_queue_cp.hpp>
+
+#if defined(__linux__)
+	#include <sys/socket.h>
+	#include <sys/uio.h>
+	#include <netinet/in.h>
+	#include <netinet/udp.h>
+#endif
 
 namespace asio2::detail
 {
@@ -40,12 +51,54 @@ namespace asio2::detail
 		 */
 		~udp_send_op() = default;
 
+	public:
+		/**
+		 * @function : set the send batching, when the executing send is going to be sent and there are
+		 * other sends queued after it, up to max_count datagrams are sent by one sendmmsg call, then the
+		 * callback of each send is called in order. 0 or 1 means disable.
+		 * It's only supported on linux, you should call this function before the send.
+		 */
+		inline derived_t & send_batching(std::size_t max_count)
+		{
+			this->batch_count_ = max_count;
+			return (derive);
+		}
+
+		/**
+		 * @function : get the max number of the datagrams which can be sent by one sendmmsg call
+		 */
+		inline std::size_t send_batching() const { return this->batch_count_; }
+
+		/**
+		 * @function : enable the UDP_SEGMENT (GSO, linux) for the send batching, the consecutive datagrams
+		 * of a batch which have the same destination and the same size (the last one can be shorter) are
+		 * passed to the kernel as one large buffer, the kernel splits it into the datagrams again, so the
+		 * receiver still gets the same datagrams. If the kernel or the nic refuses it, the GSO is disabled
+		 * and the datagrams are sent one by one. You should call send_batching before it.
+		 */
+		inline derived_t & send_gso(bool enable)
+		{
+			this->gso_ = enable;
+			return (derive);
+		}
+
+		/**
+		 * @function : check whether the UDP_SEGMENT is enabled
+		 */
+		inline bool send_gso() const { return this->gso_; }
+
 	protected:
 		template<class Data, class Callback>
 		inline bool _udp_send(Data& data, Callback&& callback)
 		{
 #if defined(ASIO2_SEND_CORE_ASYNC)
-			derive.stream().async_send(asio::buffer(data), asio::bind_executor(derive.io().strand(),
+#if defined(__linux__)
+			if (this->batch_count_ > 1 && derive._next_queued_event())
+			{
+				return derive._udp_send_batch(nullptr, to_buffers(data), std::forward<Callback>(callback));
+			}
+#endif
+			derive.stream().async_send(to_buffers(data), asio::bind_executor(derive.io().strand(),
 				make_allocator(derive.wallocator(),
 					[this, p = derive.selfptr(), callback = std::forward<Callback>(callback)]
 			(const error_code& ec, std::size_t bytes_sent) mutable
@@ -59,7 +112,7 @@ namespace asio2::detail
 			return true;
 #else
 			error_code ec;
-			std::size_t bytes_sent = derive.stream().send(asio::buffer(data), 0, ec);
+			std::size_t bytes_sent = derive.stream().send(to_buffers(data), 0, ec);
 			set_last_error(ec);
 			callback(ec, bytes_sent);
 			return (!bool(ec));
@@ -70,7 +123,13 @@ namespace asio2::detail
 		inline bool _udp_send_to(Endpoint& endpoint, Data& data, Callback&& callback)
 		{
 #if defined(ASIO2_SEND_CORE_ASYNC)
-			derive.stream().async_send_to(asio::buffer(data), endpoint, asio::bind_executor(derive.io().strand(),
+#if defined(__linux__)
+			if (this->batch_count_ > 1 && derive._next_queued_event())
+			{
+				return derive._udp_send_batch(&endpoint, to_buffers(data), std::forward<Callback>(callback));
+			}
+#endif
+			derive.stream().async_send_to(to_buffers(data), endpoint, asio::bind_executor(derive.io().strand(),
 				make_allocator(derive.wallocator(),
 					[this, p = derive.selfptr(), callback = std::forward<Callback>(callback)]
 			(const error_code& ec, std::size_t bytes_sent) mutable
@@ -84,15 +143,299 @@ namespace asio2::detail
 			return true;
 #else
 			error_code ec;
-			std::size_t bytes_sent = derive.stream().send_to(asio::buffer(data), endpoint, 0, ec);
+			std::size_t bytes_sent = derive.stream().send_to(to_buffers(data), endpoint, 0, ec);
 			set_last_error(ec);
 			callback(ec, bytes_sent);
 			return (!bool(ec));
 #endif
 		}
 
+#if defined(ASIO2_SEND_CORE_ASYNC) && defined(__linux__)
+		struct batched_datagram
+		{
+			std::unique_ptr<event_base> event;
+			asio::ip::udp::endpoint     endpoint;
+			bool                        connected;
+			std::size_t                 first;
+			std::size_t                 count;
+			std::size_t                 size;
+			error_code                  ec;
+		};
+
+		/// the max number of the segments and the max bytes of one UDP_SEGMENT send
+		static constexpr std::size_t gso_max_segments = 64;
+		static constexpr std::size_t gso_max_bytes    = 65000;
+
+		/// the control buffer size of each message in words, the UDP_SEGMENT cmsg carries an uint16
+		static constexpr std::size_t gso_control_words = (CMSG_SPACE(sizeof(std::uint16_t)) +
+			sizeof(std::uint64_t) - 1) / sizeof(std::uint64_t);
+
+		struct send_batch
+		{
+			std::vector<batched_datagram>   datagrams;
+			std::vector<asio::const_buffer> buffers;
+			std::vector<struct iovec>       iovecs;
+			/// the first datagram of each message, a message contains several datagrams with the GSO
+			std::vector<std::size_t>        messages;
+			std::vector<struct mmsghdr>     headers;
+			std::vector<std::uint64_t>      controls;
+			/// the number of the datagrams which are sent
+			std::size_t                     sent = 0;
+			/// the message which is going to be sent
+			std::size_t                     next = 0;
+		};
+
+		/**
+		 * gather the data of the executing send and the sends queued after it, each of them is a
+		 * datagram, and send them by sendmmsg. the queued sends are detached from the event queue,
+		 * their callbacks are called after the batch is sent.
+		 * endpoint is nullptr if the socket is connected.
+		 */
+		template<class BufferSequence, class Callback>
+		inline bool _udp_send_batch(const asio::ip::udp::endpoint * endpoint, BufferSequence&& buffer,
+			Callback&& callback)
+		{
+			std::unique_ptr<send_batch> batch = std::make_unique<send_batch>();
+			batch->datagrams.reserve(this->batch_count_);
+
+			// the first is the data of the executing send, it's always sent
+			for (event_base * e = nullptr; batch->datagrams.size() < this->batch_count_;
+				e = derive._next_queued_event())
+			{
+				std::size_t pos = batch->buffers.size();
+
+				const asio::ip::udp::endpoint * dest = endpoint;
+
+				if (batch->datagrams.empty())
+				{
+					batch->buffers.insert(batch->buffers.end(),
+						asio::buffer_sequence_begin(buffer), asio::buffer_sequence_end(buffer));
+				}
+				else
+				{
+					if (!e)
+						break;
+
+					// the queued send of the session or the connected socket has no its own destination
+					if (e->endpoint())
+						dest = e->endpoint();
+
+					if ((!endpoint && dest) || !e->gather(batch->buffers))
+					{
+						batch->buffers.resize(pos);
+						break;
+					}
+				}
+
+				std::size_t size = 0;
+				for (std::size_t i = pos; i < batch->buffers.size(); ++i)
+					size += batch->buffers[i].size();
+
+				batch->datagrams.emplace_back(batched_datagram{ batch->datagrams.empty() ?
+					std::unique_ptr<event_base>{} : derive._detach_next_queued_event(),
+					dest ? *dest : asio::ip::udp::endpoint{}, dest == nullptr,
+					pos, batch->buffers.size() - pos, size, error_code{} });
+			}
+
+			// the vectors can't be changed any more, the headers point to their elements
+			batch->iovecs.reserve(batch->buffers.size());
+			for (asio::const_buffer & b : batch->buffers)
+				batch->iovecs.emplace_back(iovec{ const_cast<void*>(b.data()), b.size() });
+
+			this->_udp_send_batch_build(*batch, this->gso_);
+
+			derive._udp_send_batch_some(std::move(batch), std::forward<Callback>(callback));
+			return true;
+		}
+
+		/**
+		 * whether the datagram j can be appended to the GSO message which begins at the datagram i,
+		 * all the segments must have the same size except the last one, which can be shorter.
+		 */
+		inline bool _udp_gso_joinable(send_batch & batch, std::size_t i, std::size_t j, std::size_t bytes)
+		{
+			batched_datagram & first = batch.datagrams[i];
+			batched_datagram & prev  = batch.datagrams[j - 1];
+			batched_datagram & d     = batch.datagrams[j];
+
+			return (j - i < gso_max_segments && first.size > 0 && d.size > 0 &&
+				prev.size == first.size && d.size <= first.size && bytes + d.size <= gso_max_bytes &&
+				d.connected == first.connected && (d.connected || d.endpoint == first.endpoint));
+		}
+
+		/**
+		 * build the messages of the datagrams which are not sent yet, if gso is true, the joinable
+		 * datagrams are merged into one message with the UDP_SEGMENT cmsg. the iovecs of the datagrams
+		 * are contiguous, so a message just points to the iovecs of its datagrams.
+		 */
+		inline void _udp_send_batch_build(send_batch & batch, bool gso)
+		{
+			batch.messages.clear();
+			batch.next = 0;
+
+			for (std::size_t i = batch.sent; i < batch.datagrams.size();)
+			{
+				std::size_t j = i + 1, bytes = batch.datagrams[i].size;
+
+				if (gso)
+				{
+					for (; j < batch.datagrams.size() && this->_udp_gso_joinable(batch, i, j, bytes); ++j)
+						bytes += batch.datagrams[j].size;
+				}
+
+				batch.messages.emplace_back(i);
+				i = j;
+			}
+
+			batch.headers.assign(batch.messages.size(), mmsghdr{});
+			batch.controls.assign(gso ? batch.messages.size() * gso_control_words : 0, 0);
+
+			for (std::size_t k = 0; k < batch.messages.size(); ++k)
+			{
+				std::size_t first = batch.messages[k], last = this->_udp_message_end(batch, k);
+
+				batched_datagram & d = batch.datagrams[first];
+				struct msghdr & h = batch.headers[k].msg_hdr;
+				h.msg_name    = d.connected ? nullptr : d.endpoint.data();
+				h.msg_namelen = d.connected ? 0 : static_cast<socklen_t>(d.endpoint.size());
+				h.msg_iov     = batch.iovecs.data() + d.first;
+				h.msg_iovlen  = 0;
+				for (std::size_t i = first; i < last; ++i)
+					h.msg_iovlen += batch.datagrams[i].count;
+
+			#if defined(UDP_SEGMENT)
+				if (last - first > 1)
+				{
+					h.msg_control    = batch.controls.data() + k * gso_control_words;
+					h.msg_controllen = CMSG_SPACE(sizeof(std::uint16_t));
+
+					struct cmsghdr * c = CMSG_FIRSTHDR(&h);
+					c->cmsg_level = IPPROTO_UDP;
+					c->cmsg_type  = UDP_SEGMENT;
+					c->cmsg_len   = CMSG_LEN(sizeof(std::uint16_t));
+
+					std::uint16_t segment = static_cast<std::uint16_t>(d.size);
+					std::memcpy(CMSG_DATA(c), &segment, sizeof(std::uint16_t));
+				}
+			#endif
+			}
+		}
+
+		/**
+		 * the end of the datagrams of the message k
+		 */
+		inline std::size_t _udp_message_end(send_batch & batch, std::size_t k)
+		{
+			return (k + 1 < batch.messages.size() ? batch.messages[k + 1] : batch.datagrams.size());
+		}
+
+		/**
+		 * send the remaining datagrams of the batch without blocking, wait for the socket to be
+		 * writable if the send buffer of the socket is full.
+		 */
+		template<class Callback>
+		inline void _udp_send_batch_some(std::unique_ptr<send_batch> batch, Callback&& callback)
+		{
+			error_code ec;
+
+			while (batch->next < batch->messages.size())
+			{
+				int n = ::sendmmsg(derive.stream().native_handle(), batch->headers.data() + batch->next,
+					static_cast<unsigned int>(batch->messages.size() - batch->next), MSG_DONTWAIT);
+				if (n < 0)
+				{
+					ec.assign(errno, asio::error::get_system_category());
+
+					if (ec == asio::error::would_block || ec == asio::error::try_again)
+						break;
+
+					std::size_t last = this->_udp_message_end(*batch, batch->next);
+
+					// the kernel or the nic doesn't support the GSO of the message, send them one by one
+					if (last - batch->sent > 1 && (ec == asio::error::invalid_argument ||
+						ec == asio::error::message_size || ec.value() == EIO || ec.value() == ENOPROTOOPT))
+					{
+						this->gso_ = false;
+						this->_udp_send_batch_build(*batch, false);
+						ec.clear();
+						continue;
+					}
+
+					// the datagram which can't be sent is skipped, the others are still sent
+					for (; batch->sent < last; ++(batch->sent))
+						batch->datagrams[batch->sent].ec = ec;
+
+					++(batch->next);
+					ec.clear();
+					continue;
+				}
+
+				for (int i = 0; i < n; ++i)
+				{
+					batch->sent = this->_udp_message_end(*batch, batch->next);
+					++(batch->next);
+				}
+			}
+
+			if (ec)
+			{
+				derive.stream().async_wait(asio::socket_base::wait_write, asio::bind_executor(derive.io().strand(),
+					make_allocator(derive.wallocator(),
+						[this, p = derive.selfptr(), batch = std::move(batch), callback = std::forward<Callback>(callback)]
+				(const error_code& ec) mutable
+				{
+					if (ec)
+					{
+						for (std::size_t i = batch->sent; i < batch->datagrams.size(); ++i)
+							batch->datagrams[i].ec = ec;
+
+						batch->sent = batch->datagrams.size();
+						batch->next = batch->messages.size();
+
+						return derive._udp_send_batch_done(std::move(batch), std::move(callback));
+					}
+
+					derive._udp_send_batch_some(std::move(batch), std::move(callback));
+				})));
+				return;
+			}
+
+			// the callbacks must be called after the executing send is returned
+			asio::post(derive.io().strand(), make_allocator(derive.wallocator(),
+				[this, p = derive.selfptr(), batch = std::move(batch), callback = std::forward<Callback>(callback)]
+			() mutable
+			{
+				derive._udp_send_batch_done(std::move(batch), std::move(callback));
+			}));
+		}
+
+		template<class Callback>
+		inline void _udp_send_batch_done(std::unique_ptr<send_batch> batch, Callback&& callback)
+		{
+			for (batched_datagram & d : batch->datagrams)
+			{
+				set_last_error(d.ec);
+
+				std::size_t bytes_sent = (d.ec ? 0 : d.size);
+
+				if (d.event)
+					d.event->complete(d.ec, bytes_sent);
+				else
+					callback(d.ec, bytes_sent);
+			}
+
+			derive.next_event();
+		}
+#endif
+
 	protected:
 		derived_t & derive;
+
+		/// the max number of the datagrams which can be sent by one sendmmsg call
+		std::size_t batch_count_ = 0;
+
+		/// whether merge the datagrams of a batch by the UDP_SEGMENT
+		bool        gso_ = false;
 	};
 }
 
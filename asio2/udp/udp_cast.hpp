@@ -46,6 +46,7 @@
 #include <asio2/base/component/event_queue_cp.hpp>
 
 #include <asio2/base/detail/linear_buffer.hpp>
+#include <asio2/udp/detail/recv_ring.hpp>
 #include <asio2/udp/component/udp_send_cp.hpp>
 #include <asio2/udp/impl/udp_send_op.hpp>
 
@@ -146,6 +147,39 @@ namespace asio2::detail
 			this->iopool_.stop();
 		}
 
+		/**
+		 * @function : enable the batch receiving, when the socket is readable, up to count datagrams which
+		 * are already arrived are received by one recvmmsg call (linux), then the recv notification is fired
+		 * for each of them. 0 or 1 means disable. You should call this function before start.
+		 */
+		inline derived_t & recv_batch(std::size_t count)
+		{
+			this->recv_batch_ = count;
+			return (this->derived());
+		}
+
+		/**
+		 * @function : get the max number of the datagrams received by one batch
+		 */
+		inline std::size_t recv_batch() const { return this->recv_batch_; }
+
+		/**
+		 * @function : enable the UDP_GRO (linux), the kernel coalesces the datagrams of the same sender
+		 * into one buffer, they are split by the segment size before dispatching, so the recv notification
+		 * is still fired for each datagram. It uses the buffers of the batch receiving, each buffer is
+		 * 64KB, the count of them is specified by recv_batch. You should call this function before start.
+		 */
+		inline derived_t & recv_gro(bool enable)
+		{
+			this->recv_gro_ = enable;
+			return (this->derived());
+		}
+
+		/**
+		 * @function : check whether the UDP_GRO is enabled
+		 */
+		inline bool recv_gro() const { return this->recv_gro_; }
+
 		/**
 		 * @function : check whether the client is started
 		 */
@@ -304,6 +338,14 @@ namespace asio2::detail
 
 				asio::detail::throw_error(ec);
 
+				if (this->recv_batch_ > 1 || this->recv_gro_)
+				{
+					bool gro = (this->recv_gro_ && udp_recv_ring::enable_gro(this->socket_));
+					this->ring_.reset((std::max)(this->recv_batch_, std::size_t(1)),
+						gro ? udp_gro_buffer_size : this->buffer_.pre_size(), gro);
+					udp_recv_ring::prepare(this->socket_);
+				}
+
 				asio::post(this->io_.strand(), [this, condition]()
 				{
 					this->buffer_.consume(this->buffer_.size());
@@ -329,6 +371,14 @@ namespace asio2::detail
 				return this->derived()._post_stop(ec, std::shared_ptr<derived_t>{}, expected);
 		}
 
+		/**
+		 * the udp cast has no connection, the send policy disconnect stops it.
+		 */
+		inline void _do_disconnect(const error_code& ec)
+		{
+			this->derived()._do_stop(ec);
+		}
+
 		inline void _post_stop(const error_code& ec, std::shared_ptr<derived_t> self_ptr, state_t old_state)
 		{
 			// psot a recv signal to ensure that all recv events has finished already.
@@ -385,6 +435,9 @@ namespace asio2::detail
 			if (!this->is_started())
 				return;
 
+			if (this->recv_batch_ > 1 || this->recv_gro_)
+				return this->derived()._post_recv_batch(std::move(condition));
+
 			try
 			{
 				this->socket_.async_receive_from(
@@ -429,6 +482,65 @@ namespace asio2::detail
 			this->derived()._post_recv(condition);
 		}
 
+		template<typename MatchCondition>
+		void _post_recv_batch(condition_wrap<MatchCondition> condition)
+		{
+			try
+			{
+				this->socket_.async_wait(asio::socket_base::wait_read,
+					asio::bind_executor(this->io_.strand(), make_allocator(this->rallocator_,
+						[this, condition](const error_code& ec)
+				{
+					this->derived()._handle_recv_batch(ec, condition);
+				})));
+			}
+			catch (system_error & e)
+			{
+				set_last_error(e);
+				this->derived()._do_stop(e.code());
+			}
+		}
+
+		template<typename MatchCondition>
+		void _handle_recv_batch(const error_code& ec, condition_wrap<MatchCondition> condition)
+		{
+			set_last_error(ec);
+
+			if (ec == asio::error::operation_aborted)
+			{
+				this->derived()._do_stop(ec);
+				return;
+			}
+
+			// read a few rounds at most, then give the other events of the strand a chance to run
+			for (int round = 0; !ec && round < 4 && this->is_started(); ++round)
+			{
+				error_code er;
+				std::size_t n = this->ring_.receive(this->socket_, er);
+
+				if (er && er != asio::error::would_block && er != asio::error::try_again)
+					set_last_error(er);
+
+				for (std::size_t i = 0; i < n && this->is_started(); ++i)
+				{
+					this->remote_endpoint_ = this->ring_.endpoint(i);
+
+					this->ring_.for_each(i, [this](std::string_view s)
+					{
+						this->derived()._fire_recv(std::shared_ptr<derived_t>{}, s);
+					});
+				}
+
+				if (n < this->ring_.capacity())
+					break;
+			}
+
+			if (!this->is_started())
+				return;
+
+			this->derived()._post_recv(condition);
+		}
+
 		inline void _fire_init()
 		{
 			this->listener_.notify(event::init);
@@ -449,6 +561,11 @@ namespace asio2::detail
 			this->listener_.notify(event::stop, ec);
 		}
 
+		inline void _fire_send_pressure(detail::ignore, bool high)
+		{
+			this->listener_.notify(event::send_pressure, std::move(high));
+		}
+
 	public:
 		/**
 		 * @function : get the buffer object refrence
@@ -495,6 +612,15 @@ namespace asio2::detail
 
 		/// endpoint for udp 
 		asio::ip::udp::endpoint                     remote_endpoint_;
+
+		/// the max number of the datagrams received by one batch, 0 or 1 means disable
+		std::size_t                                 recv_batch_ = 0;
+
+		/// whether enable the UDP_GRO
+		bool                                        recv_gro_ = false;
+
+		/// the buffers of the batch receiving
+		udp_recv_ring                               ring_;
 	};
 }
 
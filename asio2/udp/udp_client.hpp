@@ -18,6 +18,7 @@
 #include <asio2/base/client.hpp>
 #include <asio2/base/detail/linear_buffer.hpp>
 #include <asio2/udp/impl/udp_send_op.hpp>
+#include <asio2/udp/detail/recv_ring.hpp>
 #include <asio2/udp/detail/kcp_util.hpp>
 #include <asio2/udp/component/kcp_stream_cp.hpp>
 
@@ -146,6 +147,39 @@ namespace asio2::detail
 			this->iopool_.stop();
 		}
 
+		/**
+		 * @function : enable the batch receiving, when the socket is readable, up to count datagrams which
+		 * are already arrived are received by one recvmmsg call (linux), then the recv notification is fired
+		 * for each of them. 0 or 1 means disable. You should call this function before start.
+		 */
+		inline derived_t & recv_batch(std::size_t count)
+		{
+			this->recv_batch_ = count;
+			return (this->derived());
+		}
+
+		/**
+		 * @function : get the max number of the datagrams received by one batch
+		 */
+		inline std::size_t recv_batch() const { return this->recv_batch_; }
+
+		/**
+		 * @function : enable the UDP_GRO (linux), the kernel coalesces the datagrams of the server into
+		 * one buffer, they are split by the segment size before the recv notification, so the notification
+		 * is still fired for each datagram. It uses the buffers of the batch receiving, each buffer is 64KB,
+		 * the count of them is specified by recv_batch. You should call this function before start.
+		 */
+		inline derived_t & recv_gro(bool enable)
+		{
+			this->recv_gro_ = enable;
+			return (this->derived());
+		}
+
+		/**
+		 * @function : check whether the UDP_GRO is enabled
+		 */
+		inline bool recv_gro() const { return this->recv_gro_; }
+
 	public:
 		/**
 		 * @function : get the kcp pointer, just used for kcp mode
@@ -158,6 +192,36 @@ namespace asio2::detail
 			return (this->kcp_ ? this->kcp_->kcp_ : nullptr);
 		}
 
+		/**
+		 * @function : set the kcp config, just used for kcp mode, it can be called before start,
+		 * or after the handshake to tune the kcp, the config is applied in the io thread.
+		 * After the handshake only the local parameters (nodelay, interval, resend, nc, sndwnd,
+		 * rcvwnd, minrto) are changed, the mtu, stream, fec_data and fec_parity are fixed by the
+		 * handshake with the peer, and the changes of them are ignored until the next start.
+		 */
+		inline derived_t & kcp_config(const detail::kcp_config & config)
+		{
+			if (this->is_stopped() || this->io_.strand().running_in_this_thread())
+			{
+				if (!this->is_stopped() && this->kcp())
+					this->kcp_->_kcp_tune(config);
+				else
+					this->kcp_config_ = config;
+				return (this->derived());
+			}
+
+			asio::post(this->io_.strand(), [this, config]()
+			{
+				this->kcp_config(config);
+			});
+			return (this->derived());
+		}
+
+		/**
+		 * @function : get the kcp config
+		 */
+		inline const detail::kcp_config & kcp_config() const { return this->kcp_config_; }
+
 	public:
 		/**
 		 * @function : bind recv listener
@@ -307,7 +371,14 @@ namespace asio2::detail
 		inline void _do_init(condition_wrap<MatchCondition>)
 		{
 			if constexpr (std::is_same_v<MatchCondition, use_kcp_t>)
+			{
 				this->kcp_ = std::make_unique<kcp_stream_cp<derived_t, false>>(this->derived(), this->io_);
+
+				// the kcp packs the segments into the datagrams of the mtu size, a datagram which is
+				// larger than the receive buffer would be truncated
+				this->buffer_.pre_size((std::min)(this->buffer_.max_size(),
+					(std::max)(this->buffer_.pre_size(), this->kcp_config_.frame_size())));
+			}
 			else
 				this->kcp_.reset();
 		}
@@ -397,6 +468,23 @@ namespace asio2::detail
 			{
 				this->derived().buffer().consume(this->derived().buffer().size());
 
+				if (this->recv_batch_ > 1 || this->recv_gro_)
+				{
+					try
+					{
+						bool gro = (this->recv_gro_ && udp_recv_ring::enable_gro(this->socket_));
+						this->ring_.reset((std::max)(this->recv_batch_, std::size_t(1)),
+							gro ? udp_gro_buffer_size : this->buffer_.pre_size(), gro);
+						udp_recv_ring::prepare(this->socket_);
+					}
+					catch (system_error & e)
+					{
+						set_last_error(e);
+						this->derived()._do_disconnect(e.code());
+						return;
+					}
+				}
+
 				this->derived()._post_recv(std::move(this_ptr), std::move(condition));
 			});
 		}
@@ -416,6 +504,9 @@ namespace asio2::detail
 			if (!this->is_started())
 				return;
 
+			if (this->recv_batch_ > 1 || this->recv_gro_)
+				return this->derived()._post_recv_batch(std::move(this_ptr), std::move(condition));
+
 			try
 			{
 				this->socket_.async_receive(this->buffer_.prepare(this->buffer_.pre_size()),
@@ -451,39 +542,104 @@ namespace asio2::detail
 
 			if (!ec)
 			{
-				this->reset_active_time();
+				this->derived()._handle_datagram(this_ptr, std::string_view(static_cast
+					<std::string_view::const_pointer>(this->buffer_.data().data()), bytes_recvd), condition);
+			}
 
-				std::string_view s = std::string_view(static_cast<std::string_view::const_pointer>
-					(this->buffer_.data().data()), bytes_recvd);
+			this->buffer_.consume(this->buffer_.size());
 
-				if constexpr (!std::is_same_v<MatchCondition, use_kcp_t>)
+			this->derived()._post_recv(std::move(this_ptr), condition);
+		}
+
+		template<typename MatchCondition>
+		void _post_recv_batch(std::shared_ptr<derived_t> this_ptr, condition_wrap<MatchCondition> condition)
+		{
+			try
+			{
+				this->socket_.async_wait(asio::socket_base::wait_read,
+					asio::bind_executor(this->io_.strand(), make_allocator(this->rallocator_,
+						[this, self_ptr = std::move(this_ptr), condition](const error_code & ec) mutable
 				{
-					this->derived()._fire_recv(this_ptr, std::move(s));
-				}
-				else
+					this->derived()._handle_recv_batch(ec, std::move(self_ptr), condition);
+				})));
+			}
+			catch (system_error & e)
+			{
+				set_last_error(e);
+				this->derived()._do_disconnect(e.code());
+			}
+		}
+
+		template<typename MatchCondition>
+		void _handle_recv_batch(const error_code & ec, std::shared_ptr<derived_t> this_ptr,
+			condition_wrap<MatchCondition> condition)
+		{
+			set_last_error(ec);
+
+			if (ec == asio::error::operation_aborted)
+			{
+				this->derived()._do_disconnect(ec);
+				return;
+			}
+
+			// read a few rounds at most, then give the other events of the strand a chance to run
+			for (int round = 0; !ec && round < 4 && this->is_started(); ++round)
+			{
+				error_code er;
+				std::size_t n = this->ring_.receive(this->socket_, er);
+
+				if (er && er != asio::error::would_block && er != asio::error::try_again)
+					set_last_error(er);
+
+				for (std::size_t i = 0; i < n && this->is_started(); ++i)
 				{
-					if (s.size() == sizeof(kcp::kcphdr))
+					this->ring_.for_each(i, [this, &this_ptr, &condition](std::string_view s)
 					{
-						if /**/ (kcp::is_kcphdr_fin(s))
-						{
-							this->kcp_->send_fin_ = false;
-							this->derived()._do_disconnect(asio::error::eof);
-						}
-						else if (kcp::is_kcphdr_synack(s, this->kcp_->seq_))
-						{
-							ASIO2_ASSERT(false);
-						}
-					}
-					else
-						this->kcp_->_kcp_recv(this_ptr, s, this->buffer_);
+						this->derived()._handle_datagram(this_ptr, s, condition);
+					});
 				}
+
+				if (n < this->ring_.capacity())
+					break;
 			}
 
-			this->buffer_.consume(this->buffer_.size());
+			if (!this->is_started())
+				return;
 
 			this->derived()._post_recv(std::move(this_ptr), condition);
 		}
 
+		template<typename MatchCondition>
+		inline void _handle_datagram(std::shared_ptr<derived_t> & this_ptr, std::string_view s,
+			condition_wrap<MatchCondition> & condition)
+		{
+			detail::ignore::unused(condition);
+
+			this->reset_active_time();
+
+			if constexpr (!std::is_same_v<MatchCondition, use_kcp_t>)
+			{
+				this->derived()._fire_recv(this_ptr, std::move(s));
+			}
+			else
+			{
+				if (s.size() == sizeof(kcp::kcphdr))
+				{
+					if /**/ (kcp::is_kcphdr_fin(s))
+					{
+						this->kcp_->send_fin_ = false;
+						this->derived()._do_disconnect(asio::error::eof);
+					}
+					else if (kcp::is_kcphdr_synack(s, this->kcp_->seq_))
+					{
+						ASIO2_ASSERT(false);
+					}
+				}
+				else
+					this->kcp_->_kcp_recv(this_ptr, s, this->buffer_);
+			}
+		}
+
 		inline void _fire_init()
 		{
 			this->listener_.notify(event::init);
@@ -511,6 +667,18 @@ namespace asio2::detail
 
 	protected:
 		std::unique_ptr<kcp_stream_cp<derived_t, false>> kcp_;
+
+		/// the kcp config
+		detail::kcp_config                               kcp_config_;
+
+		/// the max number of the datagrams received by one batch, 0 or 1 means disable
+		std::size_t                                      recv_batch_ = 0;
+
+		/// whether enable the UDP_GRO
+		bool                                             recv_gro_ = false;
+
+		/// the buffers of the batch receiving
+		udp_recv_ring                                    ring_;
 	};
 }
 
@@ -18,6 +18,7 @@
 #include <asio2/base/server.hpp>
 #include <asio2/udp/udp_session.hpp>
 #include <asio2/base/detail/linear_buffer.hpp>
+#include <asio2/udp/detail/recv_ring.hpp>
 
 namespace asio2::detail
 {
@@ -32,17 +33,70 @@ namespace asio2::detail
 		using super = server_impl_t<derived_t, session_t>;
 		using session_type = session_t;
 
+	protected:
+		using lookup_cache = typename session_mgr_t<session_t>::lookup_cache;
+
+		/**
+		 * the socket of the reuse port mode, it's bound to the io which receives on it.
+		 */
+		struct reuse_port_socket
+		{
+			explicit reuse_port_socket(io_t & io_ref, session_mgr_t<session_t> & sessions,
+				std::size_t init_buffer_size, std::size_t max_buffer_size)
+				: io(io_ref), socket(io_ref.context()), buffer(init_buffer_size, max_buffer_size), cache(sessions) {}
+
+			io_t                                   & io;
+
+			asio::ip::udp::socket                    socket;
+
+			asio::ip::udp::endpoint                  remote_endpoint;
+
+			asio2::buffer_wrap<asio2::linear_buffer> buffer;
+
+			udp_recv_ring                            ring;
+
+			lookup_cache                             cache;
+
+			handler_memory<>                         allocator;
+		};
+
+		/**
+		 * the receiving state of a socket, the index 0 is the acceptor_, the others are the sockets of
+		 * the reuse port mode.
+		 */
+		struct recv_context
+		{
+			io_t                                     & io;
+
+			asio::ip::udp::socket                    & socket;
+
+			asio::ip::udp::endpoint                  & remote_endpoint;
+
+			asio2::buffer_wrap<asio2::linear_buffer> & buffer;
+
+			udp_recv_ring                            & ring;
+
+			lookup_cache                             & cache;
+
+			handler_memory<>                         & allocator;
+		};
+
+	public:
 		/**
 		 * @constructor
+		 * @param    : concurrency - the io thread count, the io threads other than the first one
+		 * are only used by the reuse port mode.
 		 */
 		explicit udp_server_impl_t(
 			std::size_t init_buffer_size = udp_frame_size,
-			std::size_t max_buffer_size = (std::numeric_limits<std::size_t>::max)()
+			std::size_t max_buffer_size = (std::numeric_limits<std::size_t>::max)(),
+			std::size_t concurrency = 1
 		)
-			: super(1)
+			: super(concurrency)
 			, acceptor_(this->io_.context())
 			, remote_endpoint_()
 			, buffer_(init_buffer_size, max_buffer_size)
+			, cache_(this->sessions_)
 		{
 		}
 
@@ -105,6 +159,86 @@ namespace asio2::detail
 			this->iopool_.stop();
 		}
 
+		/**
+		 * @function : enable the batch receiving, when the socket is readable, up to count datagrams which
+		 * are already arrived are received by one recvmmsg call (linux), then they are dispatched to the
+		 * sessions in a batch. 0 or 1 means disable. You should call this function before start.
+		 */
+		inline derived_t & recv_batch(std::size_t count)
+		{
+			this->recv_batch_ = count;
+			return (this->derived());
+		}
+
+		/**
+		 * @function : get the max number of the datagrams received by one batch
+		 */
+		inline std::size_t recv_batch() const { return this->recv_batch_; }
+
+		/**
+		 * @function : enable the UDP_GRO (linux), the kernel coalesces the datagrams of the same sender
+		 * into one buffer, they are split by the segment size before dispatching, so the recv notification
+		 * is still fired for each datagram. It uses the buffers of the batch receiving, each buffer is
+		 * 64KB, the count of them is specified by recv_batch. You should call this function before start.
+		 */
+		inline derived_t & recv_gro(bool enable)
+		{
+			this->recv_gro_ = enable;
+			return (this->derived());
+		}
+
+		/**
+		 * @function : check whether the UDP_GRO is enabled
+		 */
+		inline bool recv_gro() const { return this->recv_gro_; }
+
+		/**
+		 * @function : set the kcp config of the sessions, just used for kcp mode, the sessions which
+		 * are created later use this config, each session can be tuned by its own kcp_config function
+		 * after the handshake. You should call this function before start.
+		 */
+		inline derived_t & kcp_config(const detail::kcp_config & config)
+		{
+			this->kcp_config_ = config;
+			return (this->derived());
+		}
+
+		/**
+		 * @function : get the kcp config of the sessions
+		 */
+		inline const detail::kcp_config & kcp_config() const { return this->kcp_config_; }
+
+		/**
+		 * @function : enable the reuse port mode, the server opens a socket with the SO_REUSEPORT option
+		 * for each io_context of the iopool, the kernel dispatches the datagrams to the sockets by the hash
+		 * of the remote endpoint, so the datagrams of a remote endpoint are always received by the same
+		 * socket, and the session of the remote endpoint is created on the io thread of that socket.
+		 * The io thread count is specified by the concurrency param of the constructor.
+		 * You should call this function before start. It's only supported on linux, on the other platforms
+		 * the server falls back to the single socket.
+		 */
+		inline derived_t & reuse_port(bool enable)
+		{
+			this->reuse_port_ = enable;
+			return (this->derived());
+		}
+
+		/**
+		 * @function : check whether the reuse port mode is enabled
+		 */
+		inline bool reuse_port() const
+		{
+			return this->reuse_port_;
+		}
+
+		/**
+		 * @function : get the number of the receiving sockets
+		 */
+		inline std::size_t socket_count() const
+		{
+			return this->sockets_.size() + 1;
+		}
+
 		/**
 		 * @function : check whether the server is started
 		 */
@@ -284,6 +418,14 @@ namespace asio2::detail
 
 				this->acceptor_.open(endpoint.protocol());
 
+				// the kcp packs the segments into the datagrams of the mtu size, a datagram which is
+				// larger than the receive buffer would be truncated
+				if constexpr (std::is_same_v<MatchCondition, use_kcp_t>)
+				{
+					this->buffer_.pre_size((std::min)(this->buffer_.max_size(),
+						(std::max)(this->buffer_.pre_size(), this->kcp_config_.frame_size())));
+				}
+
 				// when you close socket in linux system,and start socket immediate,you will get like this "the address is in use",
 				// and bind is failed,but i'm suer i close the socket correct already before,why does this happen? the reasion is 
 				// the socket option "TIME_WAIT",although you close the socket,but the system not release the socket,util 2~4 
@@ -299,8 +441,39 @@ namespace asio2::detail
 
 				this->derived()._fire_init();
 
+				this->sockets_.clear();
+
+				bool reuse_port = (this->reuse_port_ && this->_reuse_port_supported() && this->iopool_.size() > 1);
+
+				if (reuse_port)
+					this->_set_reuse_port(this->acceptor_);
+
 				this->acceptor_.bind(endpoint);
 
+				if (reuse_port)
+				{
+					// if the port is 0, the other sockets must be bound to the port which is chosen by the
+					// system for the first socket
+					endpoint = this->acceptor_.local_endpoint();
+
+					for (std::size_t i = 1; i < this->iopool_.size(); ++i)
+					{
+						std::unique_ptr<reuse_port_socket> p = std::make_unique<reuse_port_socket>(
+							this->iopool_.get(i), this->sessions_, this->buffer_.pre_size(), this->buffer_.max_size());
+
+						p->socket.open(endpoint.protocol());
+						p->socket.set_option(asio::ip::udp::socket::reuse_address(true));
+						this->_set_reuse_port(p->socket);
+						p->socket.bind(endpoint);
+
+						this->sockets_.emplace_back(std::move(p));
+					}
+				}
+
+				// the sessions of a remote endpoint are always created and destroyed on the io thread of
+				// the socket which receives its datagrams, so they needn't be serialized by the acceptor.
+				this->sessions_.serialize(!reuse_port);
+
 				this->derived()._handle_start(error_code{}, std::move(condition));
 
 				return (this->is_started());
@@ -334,12 +507,27 @@ namespace asio2::detail
 
 				asio::detail::throw_error(ec);
 
-				asio::post(this->io_.strand(), [this, condition]()
+				for (std::size_t i = 0; i < this->socket_count(); ++i)
 				{
-					this->buffer_.consume(this->buffer_.size());
+					recv_context ctx = this->_recv_context(i);
 
-					this->derived()._post_recv(std::move(condition));
-				});
+					if (this->recv_batch_ > 1 || this->recv_gro_)
+					{
+						bool gro = (this->recv_gro_ && udp_recv_ring::enable_gro(ctx.socket));
+						ctx.ring.reset((std::max)(this->recv_batch_, std::size_t(1)),
+							gro ? udp_gro_buffer_size : this->buffer_.pre_size(), gro);
+						udp_recv_ring::prepare(ctx.socket);
+					}
+
+					asio::post(ctx.io.strand(), [this, i, condition]()
+					{
+						recv_context ctx = this->_recv_context(i);
+
+						ctx.buffer.consume(ctx.buffer.size());
+
+						this->derived()._post_recv(i, std::move(condition));
+					});
+				}
 			}
 			catch (system_error & e)
 			{
@@ -378,7 +566,7 @@ namespace asio2::detail
 					session_ptr->stop();
 				});
 
-				this->counter_ptr_.reset();
+				this->_release_counter();
 			});
 		}
 
@@ -395,22 +583,67 @@ namespace asio2::detail
 			this->acceptor_.shutdown(asio::socket_base::shutdown_both, ec_ignore);
 			// Call close,otherwise the _handle_recv will never return
 			this->acceptor_.close(ec_ignore);
+
+			// release the sessions which are held by the lookup cache
+			this->cache_.clear();
+
+			// the other sockets must be closed on their own io thread
+			for (std::unique_ptr<reuse_port_socket> & p : this->sockets_)
+			{
+				asio::post(p->io.strand(), [p = p.get()]()
+				{
+					p->socket.shutdown(asio::socket_base::shutdown_both, ec_ignore);
+					p->socket.close(ec_ignore);
+					p->cache.clear();
+				});
+			}
+		}
+
+		inline recv_context _recv_context(std::size_t index)
+		{
+			if (index == 0)
+				return recv_context{ this->io_, this->acceptor_, this->remote_endpoint_,
+					this->buffer_, this->ring_, this->cache_, this->allocator_ };
+
+			reuse_port_socket & p = *(this->sockets_[index - 1]);
+
+			return recv_context{ p.io, p.socket, p.remote_endpoint, p.buffer, p.ring, p.cache, p.allocator };
+		}
+
+		/**
+		 * get the receiving state of the io thread which the caller is running in, the sessions are
+		 * created in the strand of the socket which receives the first datagram.
+		 */
+		inline recv_context _current_recv_context()
+		{
+			for (std::unique_ptr<reuse_port_socket> & p : this->sockets_)
+			{
+				if (p->io.strand().running_in_this_thread())
+					return recv_context{ p->io, p->socket, p->remote_endpoint, p->buffer, p->ring, p->cache, p->allocator };
+			}
+
+			return this->_recv_context(0);
 		}
 
 		template<typename MatchCondition>
-		inline void _post_recv(condition_wrap<MatchCondition> condition)
+		inline void _post_recv(std::size_t index, condition_wrap<MatchCondition> condition)
 		{
 			if (!this->is_started())
 				return;
 
+			if (this->recv_batch_ > 1 || this->recv_gro_)
+				return this->derived()._post_recv_batch(index, std::move(condition));
+
+			recv_context ctx = this->_recv_context(index);
+
 			try
 			{
-				this->acceptor_.async_receive_from(
-					this->buffer_.prepare(this->buffer_.pre_size()), this->remote_endpoint_,
-					asio::bind_executor(this->io_.strand(), make_allocator(this->allocator_,
-						[this, condition](const error_code& ec, std::size_t bytes_recvd)
+				ctx.socket.async_receive_from(
+					ctx.buffer.prepare(ctx.buffer.pre_size()), ctx.remote_endpoint,
+					asio::bind_executor(ctx.io.strand(), make_allocator(ctx.allocator,
+						[this, index, condition](const error_code& ec, std::size_t bytes_recvd)
 				{
-					this->derived()._handle_recv(ec, bytes_recvd, condition);
+					this->derived()._handle_recv(ec, index, bytes_recvd, condition);
 				})));
 			}
 			catch (system_error & e)
@@ -421,7 +654,8 @@ namespace asio2::detail
 		}
 
 		template<typename MatchCondition>
-		inline void _handle_recv(const error_code& ec, std::size_t bytes_recvd, condition_wrap<MatchCondition> condition)
+		inline void _handle_recv(const error_code& ec, std::size_t index, std::size_t bytes_recvd,
+			condition_wrap<MatchCondition> condition)
 		{
 			set_last_error(ec);
 
@@ -434,50 +668,149 @@ namespace asio2::detail
 			if (!this->is_started())
 				return;
 
-			this->buffer_.commit(bytes_recvd);
+			recv_context ctx = this->_recv_context(index);
+
+			ctx.buffer.commit(bytes_recvd);
 
 			if (!ec)
 			{
-				std::string_view s = std::string_view(static_cast<std::string_view::const_pointer>
-					(this->buffer_.data().data()), bytes_recvd);
-
-				// first we find whether the session is in the session_mgr pool already,if not ,
-				// we new a session and put it into the session_mgr pool
-				std::shared_ptr<session_t> session_ptr = this->sessions_.find(this->remote_endpoint_);
-				if (!session_ptr)
-					this->derived()._handle_accept(ec, s, session_ptr, condition);
-				else
-					session_ptr->_handle_recv(ec, s, session_ptr, condition);
+				this->derived()._dispatch_recv(ctx, std::string_view(static_cast<std::string_view::const_pointer>
+					(ctx.buffer.data().data()), bytes_recvd), condition);
 			}
 
-			this->buffer_.consume(this->buffer_.size());
+			ctx.buffer.consume(ctx.buffer.size());
 
-			this->derived()._post_recv(condition);
+			this->derived()._post_recv(index, condition);
+		}
+
+		template<typename MatchCondition>
+		inline void _post_recv_batch(std::size_t index, condition_wrap<MatchCondition> condition)
+		{
+			recv_context ctx = this->_recv_context(index);
+
+			try
+			{
+				ctx.socket.async_wait(asio::socket_base::wait_read,
+					asio::bind_executor(ctx.io.strand(), make_allocator(ctx.allocator,
+						[this, index, condition](const error_code& ec)
+				{
+					this->derived()._handle_recv_batch(ec, index, condition);
+				})));
+			}
+			catch (system_error & e)
+			{
+				set_last_error(e);
+				this->derived()._do_stop(e.code());
+			}
+		}
+
+		template<typename MatchCondition>
+		inline void _handle_recv_batch(const error_code& ec, std::size_t index, condition_wrap<MatchCondition> condition)
+		{
+			set_last_error(ec);
+
+			if (ec == asio::error::operation_aborted)
+			{
+				this->derived()._do_stop(ec);
+				return;
+			}
+
+			recv_context ctx = this->_recv_context(index);
+
+			// read a few rounds at most, then give the other events of the strand a chance to run
+			for (int round = 0; !ec && round < 4 && this->is_started(); ++round)
+			{
+				error_code er;
+				std::size_t n = ctx.ring.receive(ctx.socket, er);
+
+				if (er && er != asio::error::would_block && er != asio::error::try_again)
+					set_last_error(er);
+
+				for (std::size_t i = 0; i < n && this->is_started(); ++i)
+				{
+					ctx.remote_endpoint = ctx.ring.endpoint(i);
+
+					ctx.ring.for_each(i, [this, &ctx, &condition](std::string_view s)
+					{
+						this->derived()._dispatch_recv(ctx, s, condition);
+					});
+				}
+
+				if (n < ctx.ring.capacity())
+					break;
+			}
+
+			if (!this->is_started())
+				return;
+
+			this->derived()._post_recv(index, condition);
+		}
+
+		template<typename MatchCondition>
+		inline void _dispatch_recv(recv_context & ctx, std::string_view s, condition_wrap<MatchCondition>& condition)
+		{
+			// first we find whether the session is in the session_mgr pool already,if not ,
+			// we new a session and put it into the session_mgr pool, the lookup cache of the socket
+			// is tried before the session_mgr.
+			std::shared_ptr<session_t> session_ptr = ctx.cache.find(ctx.remote_endpoint);
+			if (!session_ptr)
+			{
+				this->derived()._handle_accept(error_code{}, s, session_ptr, condition);
+			}
+			else if (&(session_ptr->io()) == &(ctx.io))
+			{
+				session_ptr->_handle_recv(error_code{}, s, session_ptr, condition);
+			}
+			else
+			{
+				// the kernel dispatches the datagrams of a remote endpoint to another socket when the
+				// sockets of the reuse port group are changed, the data must be copied to the session's
+				// own io thread.
+				asio::post(session_ptr->io().strand(), [session_ptr, condition, data = std::string(s)]() mutable
+				{
+					session_ptr->_handle_recv(error_code{}, data, session_ptr, condition);
+				});
+			}
 		}
 
 		template<typename... Args>
 		inline std::shared_ptr<session_t> _make_session(Args&&... args)
 		{
+			recv_context ctx = this->_current_recv_context();
+
 			return std::make_shared<session_t>(
 				std::forward<Args>(args)...,
 				this->sessions_,
 				this->listener_,
-				this->io_,
-				this->buffer_.pre_size(),
-				this->buffer_.max_size(),
-				this->buffer_,
-				this->acceptor_,
-				this->remote_endpoint_);
+				ctx.io,
+				ctx.buffer.pre_size(),
+				ctx.buffer.max_size(),
+				ctx.buffer,
+				ctx.socket,
+				ctx.remote_endpoint);
 		}
 
 		template<typename MatchCondition>
 		inline void _handle_accept(const error_code & ec, std::string_view first,
 			std::shared_ptr<session_t> session_ptr, condition_wrap<MatchCondition> condition)
 		{
+			detail::ignore::unused(ec);
+
+			// the counter is released by the stopping in the acceptor io thread
+			std::shared_ptr<void> counter_ptr = this->_load_counter();
+			if (!counter_ptr)
+				return;
+
 			session_ptr = this->derived()._make_session();
-			session_ptr->counter_ptr_ = this->counter_ptr_;
+			session_ptr->counter_ptr_ = std::move(counter_ptr);
 			session_ptr->first_ = first;
+			session_ptr->kcp_config_ = this->kcp_config_;
 			session_ptr->start(condition);
+
+			// the server may be stopped by another thread during the starting, if the stopping has
+			// traversed the sessions before this session is joined, this session must stop itself.
+			if (!this->is_started())
+				session_ptr->stop();
 		}
 
 		inline void _fire_init()
@@ -504,6 +837,27 @@ namespace asio2::detail
 
 		/// buffer
 		asio2::buffer_wrap<asio2::linear_buffer> buffer_;
+
+		/// the max number of the datagrams received by one batch, 0 or 1 means disable
+		std::size_t              recv_batch_ = 0;
+
+		/// whether enable the UDP_GRO
+		bool                     recv_gro_ = false;
+
+		/// the buffers of the batch receiving
+		udp_recv_ring            ring_;
+
+		/// the session lookup cache of the acceptor_
+		lookup_cache             cache_;
+
+		/// the kcp config of the new sessions
+		detail::kcp_config       kcp_config_;
+
+		/// whether open a socket for each io with SO_REUSEPORT
+		bool                     reuse_port_ = false;
+
+		/// the sockets of the io 1 ~ n in the reuse port mode, the io 0 uses the acceptor_
+		std::vector<std::unique_ptr<reuse_port_socket>> sockets_;
 	};
 }
 
@@ -163,6 +163,37 @@ namespace asio2::detail
 			return (this->kcp_ ? this->kcp_->kcp_ : nullptr);
 		}
 
+		/**
+		 * @function : set the kcp config of this session, just used for kcp mode, the session
+		 * gets the config of the server when it's created, call this function to tune it after
+		 * the handshake, the config is applied in the io thread of the session.
+		 * After the handshake only the local parameters (nodelay, interval, resend, nc, sndwnd,
+		 * rcvwnd, minrto) are changed, the mtu, stream, fec_data and fec_parity are fixed by the
+		 * handshake with the peer, and the changes of them are ignored.
+		 */
+		inline derived_t & kcp_config(const detail::kcp_config & config)
+		{
+			if (this->io_.strand().running_in_this_thread())
+			{
+				if (this->kcp())
+					this->kcp_->_kcp_tune(config);
+				else
+					this->kcp_config_ = config;
+				return (this->derived());
+			}
+
+			asio::post(this->io_.strand(), [this, this_ptr = this->shared_from_this(), config]()
+			{
+				this->kcp_config(config);
+			});
+			return (this->derived());
+		}
+
+		/**
+		 * @function : get the kcp config of this session
+		 */
+		inline const detail::kcp_config & kcp_config() const { return this->kcp_config_; }
+
 	protected:
 		/**
 		 * @function : get the send/write allocator object refrence
@@ -383,7 +414,7 @@ namespace asio2::detail
 						ASIO2_ASSERT(this->kcp_ && this->kcp_->kcp_);
 						// step 4 : server send synack to client
 						kcp::kcphdr * hdr = (kcp::kcphdr*)(s.data());
-						kcp::kcphdr synack = kcp::make_kcphdr_synack(this->kcp_->seq_, hdr->th_seq);
+						kcp::kcphdr synack = this->kcp_->_kcp_synack(hdr->th_seq);
 						error_code ed;
 						this->kcp_->_kcp_send_hdr(synack, ed);
 						if (ed)
@@ -427,6 +458,9 @@ namespace asio2::detail
 
 		std::unique_ptr<kcp_stream_cp<derived_t, true>> kcp_;
 
+		/// the kcp config, it's copied from the server
+		detail::kcp_config                              kcp_config_;
+
 		/// first recvd data packet
 		std::string_view                                first_;
 	};
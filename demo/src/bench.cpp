@@ -0,0 +1,74 @@
+/*
+> The benchmarks of the asio2 components, run one of them by name : ./bench.out session_mgr
+> To get the baseline of a benchmark, build it against the asio2 headers before the change.
+> Compile:
+g++ -x c++ /root/projects/bench/demo/src/bench.cpp -I /usr/local/include -I /root/projects/bench -O2 -DNDEBUG -fno-strict-aliasing -fthreadsafe-statics -fexceptions -frtti -std=c++17 -o "/root/projects/bench/bin/x64/Release/bench.out" -lpthread -lrt -ldl
+*/
+
+#ifdef _MSC_VER
+#pragma warning(disable:4996)
+#endif
+
+#include <asio2/asio2.hpp>
+#include <iostream>
+
+#include "bench_session_mgr.hpp"
+#include "bench_cross_thread_send.hpp"
+#include "bench_accept.hpp"
+#include "bench_udp_gso.hpp"
+#include "bench_kcp_sessions.hpp"
+#include "bench_kcp_loss.hpp"
+#include "bench_kcp_fec.hpp"
+#include "bench_rpc_serialize.hpp"
+#include "bench_rpc_pipeline.hpp"
+#include "check_rpc_coroutine.hpp"
+
+
+int main(int argc, char *argv[])
+{
+	std::string_view name = (argc > 1 ? argv[1] : "");
+
+	if (name == "session_mgr")
+		run_bench_session_mgr();
+	else if (name == "cross_thread_send")
+		run_bench_cross_thread_send();
+	else if (name == "accept")
+		run_bench_accept();
+	else if (name == "udp_gso")
+		run_bench_udp_gso();
+	else if (name == "kcp_sessions")
+		run_bench_kcp_sessions();
+	else if (name == "kcp_loss")
+		run_bench_kcp_loss();
+	else if (name == "kcp_fec")
+		run_bench_kcp_fec();
+	else if (name == "kcp_fec_check")
+		return (check_kcp_fec() ? 0 : 1);
+	else if (name == "rpc_serialize")
+		run_bench_rpc_serialize();
+	else if (name == "rpc_pipeline")
+		run_bench_rpc_pipeline();
+#if defined(ASIO2_RPC_COROUTINE)
+	else if (name == "rpc_co_check")
+		return (check_rpc_coroutine() ? 0 : 1);
+#endif
+	else
+	{
+		printf("usage : %s <benchmark>\n", argc > 0 ? argv[0] : "bench");
+		printf("  session_mgr       : session_mgr_t lookups while the sessions are emplaced and erased\n");
+		printf("  cross_thread_send : tcp sends pushed by several threads to one client\n");
+		printf("  accept            : tcp accepts per second, with and without the reuse port mode\n");
+		printf("  udp_gso           : udp datagrams per second, plain, with gso, with gso and gro\n");
+		printf("  kcp_sessions      : cpu usage of a kcp server with 2k and 10k idle or active sessions\n");
+		printf("  kcp_loss          : rtt and throughput of the kcp presets through a lossy relay\n");
+		printf("  kcp_fec           : one way latency through a lossy relay, with and without the fec\n");
+		printf("  kcp_fec_check     : the encode and decode round trip of the fec, exits with 1 if it fails\n");
+		printf("  rpc_serialize     : ns per rpc request encode and decode, named and compact form\n");
+		printf("  rpc_pipeline      : pipelined async rpc calls per second, and the timeouts of the pending calls\n");
+#if defined(ASIO2_RPC_COROUTINE)
+		printf("  rpc_co_check      : coroutine rpc functions on the server and the client, exits with 1 if it fails\n");
+#endif
+	}
+
+	return 0;
+};
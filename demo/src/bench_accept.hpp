@@ -0,0 +1,65 @@
+#pragma once
+
+#include <asio2/asio2.hpp>
+
+// several threads connect to the tcp server and close the connection at once, in a loop, the
+// accepted connections per second are counted by the server, with the single listening socket
+// and with the reuse port mode (a listening socket for each io).
+double bench_accept_once(bool reuse_port, std::size_t connectors, int seconds)
+{
+	asio2::tcp_server server(1024, 65535, (std::max)(std::thread::hardware_concurrency(), 2u));
+	std::atomic<std::size_t> accepted{ 0 };
+	server.bind_accept([&](auto &)
+	{
+		++accepted;
+	});
+	server.reuse_port(reuse_port).accept_concurrency(4);
+	server.start("127.0.0.1", "18411");
+
+	asio::ip::tcp::endpoint ep(asio::ip::make_address("127.0.0.1"), 18411);
+	std::atomic<bool> run{ true };
+
+	std::vector<std::thread> threads;
+	for (std::size_t i = 0; i < connectors; ++i)
+	{
+		threads.emplace_back([&]()
+		{
+			asio::io_context ioc;
+			while (run)
+			{
+				asio::ip::tcp::socket socket(ioc);
+				asio::error_code ec;
+				socket.connect(ep, ec);
+				if (ec)
+					continue;
+				// reset instead of the four way close, so the ports are not kept by the TIME_WAIT
+				socket.set_option(asio::socket_base::linger(true, 0), ec);
+				socket.close(ec);
+			}
+		});
+	}
+
+	std::this_thread::sleep_for(std::chrono::milliseconds(500));
+	std::size_t begin = accepted;
+	std::this_thread::sleep_for(std::chrono::seconds(seconds));
+	std::size_t end = accepted;
+
+	run = false;
+	for (auto & t : threads)
+		t.join();
+
+	server.stop();
+
+	return double(end - begin) / seconds;
+}
+
+void run_bench_accept()
+{
+	std::size_t connectors = (std::max)(std::size_t(std::thread::hardware_concurrency()), std::size_t(2));
+
+	for (bool reuse_port : { false, true })
+	{
+		double rate = bench_accept_once(reuse_port, connectors, 3);
+		printf("reuse_port=%d connectors=%zu : %.0f accepts/s\n", (int)reuse_port, connectors, rate);
+	}
+}
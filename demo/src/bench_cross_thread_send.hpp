@@ -0,0 +1,51 @@
+#pragma once
+
+#include <asio2/asio2.hpp>
+
+// several producer threads send small messages on one tcp client, every send is pushed into the
+// event queue from a thread other than the strand of the client. the time is measured until the
+// callbacks of all the sends are called.
+void run_bench_cross_thread_send()
+{
+	const int producers = 4, count = 50000;
+
+	asio2::tcp_server server(1536, 65535, 2);
+	std::atomic<std::size_t> received{ 0 };
+	server.bind_recv([&](auto &, std::string_view s)
+	{
+		received += s.size();
+	});
+	server.start("127.0.0.1", "18410");
+
+	asio2::tcp_client client;
+	client.send_coalescing(32);
+	client.start("127.0.0.1", "18410");
+
+	std::atomic<int> sent{ 0 };
+	auto t1 = std::chrono::steady_clock::now();
+
+	std::vector<std::thread> threads;
+	for (int t = 0; t < producers; ++t)
+	{
+		threads.emplace_back([&]()
+		{
+			for (int i = 0; i < count; ++i)
+				client.send(std::string(16, 'a'), [&]() { ++sent; });
+		});
+	}
+	for (auto & t : threads)
+		t.join();
+
+	while (sent < producers * count)
+		std::this_thread::sleep_for(std::chrono::milliseconds(1));
+
+	auto ms = std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - t1).count();
+
+	std::this_thread::sleep_for(std::chrono::milliseconds(200));
+
+	printf("producers=%d sends=%d of 16 bytes : %lld ms, received %zu bytes\n",
+		producers, producers * count, (long long)ms, (std::size_t)received);
+
+	client.stop();
+	server.stop();
+}
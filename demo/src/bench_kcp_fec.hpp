@@ -0,0 +1,140 @@
+#pragma once
+
+#include <asio2/asio2.hpp>
+#include <random>
+#include <set>
+
+#include "bench_kcp_loss.hpp"
+
+// the round trip of the reed-solomon fec : the groups are encoded, up to parity_shards datagrams of
+// each group are dropped, the others are decoded in a random order, all the packets must come out.
+bool check_kcp_fec()
+{
+	std::mt19937 rng(7);
+	std::size_t fails = 0, lost = 0;
+
+	for (int trial = 0; trial < 2000; ++trial)
+	{
+		std::size_t data = 1 + rng() % 12, parity = 1 + rng() % 5, groups = 3;
+		asio2::detail::kcp_fec encoder(data, parity, 1400), decoder(data, parity, 1400);
+
+		std::vector<std::string> packets, wire;
+		for (std::size_t i = 0; i < data * groups; ++i)
+		{
+			std::string s(24 + rng() % 1300, '\0');
+			for (char & c : s)
+				c = char(rng());
+			packets.emplace_back(s);
+			encoder.encode(s.data(), s.size(), [&](const char * p, std::size_t n) { wire.emplace_back(p, n); });
+		}
+
+		std::set<std::string> received;
+		std::size_t n = data + parity;
+		for (std::size_t g = 0; g < groups; ++g)
+		{
+			std::vector<std::size_t> order(n);
+			for (std::size_t i = 0; i < n; ++i)
+				order[i] = i;
+			std::shuffle(order.begin(), order.end(), rng);
+
+			std::size_t drop = rng() % (parity + 1);
+			for (std::size_t i = 0; i < drop; ++i)
+				lost += (order[i] < data ? 1 : 0);
+
+			for (std::size_t i = drop; i < n; ++i)
+			{
+				if (!decoder.decode(wire[g * n + order[i]], [&](std::string_view s) { received.emplace(s); }))
+					++fails;
+			}
+		}
+
+		for (auto & s : packets)
+			fails += (received.count(s) ? 0 : 1);
+	}
+
+	printf("kcp_fec round trip : %zu data shards lost and recovered, %zu fails\n", lost, fails);
+
+	return (fails == 0);
+}
+
+// the one way latency of the messages which are sent every 2 milliseconds, through a relay which
+// drops the given rate of the datagrams and delays the others by 20 milliseconds, with and without
+// the fec. the fec recovers the lost packets without waiting for the resend.
+void bench_kcp_fec_once(double loss, int data, int parity)
+{
+	kcp_loss_relay relay(18417, 18418, loss, 20);
+
+	auto now_ms = []()
+	{
+		return std::chrono::duration<double, std::milli>(
+			std::chrono::steady_clock::now().time_since_epoch()).count();
+	};
+
+	asio2::kcp_config config;
+	config.fec_data = data;
+	config.fec_parity = parity;
+
+	const int count = 1000;
+	std::mutex mtx;
+	std::vector<double> latency;
+
+	asio2::udp_server server;
+	server.kcp_config(config);
+	server.bind_recv([&](auto &, std::string_view s)
+	{
+		double t;
+		std::memcpy(&t, s.data(), sizeof(t));
+		std::lock_guard<std::mutex> guard(mtx);
+		latency.push_back(now_ms() - t);
+	});
+	server.start("127.0.0.1", "18418", asio2::use_kcp);
+
+	asio2::udp_client client;
+	client.kcp_config(config);
+	if (!client.start("127.0.0.1", "18417", asio2::use_kcp))
+	{
+		printf("loss=%2.0f%% fec=%d/%d : connect failed\n", loss * 100, data, parity);
+		server.stop();
+		return;
+	}
+
+	std::string msg(200, 'x');
+	for (int i = 0; i < count; ++i)
+	{
+		double t = now_ms();
+		std::memcpy(msg.data(), &t, sizeof(t));
+		client.send(msg);
+		std::this_thread::sleep_for(std::chrono::milliseconds(2));
+	}
+
+	auto t1 = std::chrono::steady_clock::now();
+	for (;;)
+	{
+		{
+			std::lock_guard<std::mutex> guard(mtx);
+			if (latency.size() >= std::size_t(count) || std::chrono::steady_clock::now() - t1 > std::chrono::seconds(20))
+				break;
+		}
+		std::this_thread::sleep_for(std::chrono::milliseconds(5));
+	}
+
+	client.stop();
+	server.stop();
+
+	std::sort(latency.begin(), latency.end());
+	if (latency.empty())
+		latency.push_back(0);
+
+	printf("loss=%2.0f%% fec=%2d/%d : received %zu of %d, one way p50=%.1fms p99=%.1fms, %zu datagrams\n",
+		loss * 100, data, parity, latency.size(), count, latency[latency.size() / 2],
+		latency[latency.size() * 99 / 100], relay.relayed() + relay.dropped());
+}
+
+void run_bench_kcp_fec()
+{
+	for (double loss : { 0.05, 0.1 })
+	{
+		bench_kcp_fec_once(loss, 0, 0);
+		bench_kcp_fec_once(loss, 10, 3);
+	}
+}
@@ -0,0 +1,161 @@
+#pragma once
+
+#include <asio2/asio2.hpp>
+#include <random>
+#include <deque>
+
+// a loopback relay between the kcp client and the kcp server, it drops the kcp datagrams randomly
+// with the given rate and delays the others. the handshake datagrams (the size of a kcphdr) are
+// never dropped, the connecting is not what is measured.
+class kcp_loss_relay
+{
+public:
+	kcp_loss_relay(unsigned short port, unsigned short server_port, double loss, double delay_ms = 0)
+		: socket_(ioc_, asio::ip::udp::endpoint(asio::ip::make_address("127.0.0.1"), port))
+		, server_(asio::ip::make_address("127.0.0.1"), server_port)
+		, loss_(loss), delay_(delay_ms)
+	{
+		socket_.set_option(asio::socket_base::receive_buffer_size(4 << 20));
+		socket_.non_blocking(true);
+		thread_ = std::thread([this]() { this->run(); });
+	}
+
+	~kcp_loss_relay()
+	{
+		run_ = false;
+		thread_.join();
+	}
+
+	std::size_t dropped() const { return dropped_; }
+	std::size_t relayed() const { return relayed_; }
+
+protected:
+	static double now_ms()
+	{
+		return std::chrono::duration<double, std::milli>(
+			std::chrono::steady_clock::now().time_since_epoch()).count();
+	}
+
+	void run()
+	{
+		std::mt19937 rng(1);
+		std::uniform_real_distribution<double> dist(0, 1);
+		std::deque<std::tuple<double, asio::ip::udp::endpoint, std::string>> queue;
+		asio::ip::udp::endpoint client, from;
+		std::vector<char> buf(65536);
+
+		while (run_)
+		{
+			asio::error_code ec;
+			while (!queue.empty() && std::get<0>(queue.front()) <= now_ms())
+			{
+				socket_.send_to(asio::buffer(std::get<2>(queue.front())), std::get<1>(queue.front()), 0, ec);
+				queue.pop_front();
+			}
+
+			std::size_t n = socket_.receive_from(asio::buffer(buf), from, 0, ec);
+			if (ec)
+			{
+				std::this_thread::sleep_for(std::chrono::microseconds(50));
+				continue;
+			}
+
+			if (n != sizeof(asio2::detail::kcp::kcphdr) && dist(rng) < loss_)
+			{
+				++dropped_;
+				continue;
+			}
+
+			++relayed_;
+			if (from != server_)
+				client = from;
+
+			queue.emplace_back(now_ms() + delay_, from == server_ ? client : server_, std::string(buf.data(), n));
+		}
+	}
+
+protected:
+	asio::io_context         ioc_;
+	asio::ip::udp::socket    socket_;
+	asio::ip::udp::endpoint  server_;
+	double                   loss_;
+	double                   delay_;
+	std::atomic<bool>        run_{ true };
+	std::atomic<std::size_t> dropped_{ 0 }, relayed_{ 0 };
+	std::thread              thread_;
+};
+
+// the round trip time of 300 small messages which are sent one by one, then the time to send 4MB
+// in the messages of 1000 bytes, through a relay which drops the given rate of the datagrams.
+void bench_kcp_loss_once(const char * name, asio2::kcp_config config, double loss)
+{
+	kcp_loss_relay relay(18415, 18416, loss);
+
+	asio2::udp_server server;
+	std::atomic<std::size_t> bytes{ 0 };
+	server.kcp_config(config);
+	server.bind_recv([&](auto & session_ptr, std::string_view s)
+	{
+		if (s.size() < 200)
+			session_ptr->send(std::string(s));
+		else
+			bytes += s.size();
+	});
+	server.start("127.0.0.1", "18416", asio2::use_kcp);
+
+	asio2::udp_client client;
+	std::mutex mtx;
+	std::condition_variable cv;
+	int replies = 0;
+	client.kcp_config(config);
+	client.bind_recv([&](std::string_view)
+	{
+		std::lock_guard<std::mutex> guard(mtx);
+		++replies;
+		cv.notify_one();
+	});
+	if (!client.start("127.0.0.1", "18415", asio2::use_kcp))
+	{
+		printf("%-8s loss=%2.0f%% : connect failed\n", name, loss * 100);
+		server.stop();
+		return;
+	}
+
+	std::vector<double> rtts;
+	std::string ping(64, 'p');
+	for (int i = 0; i < 300; ++i)
+	{
+		auto t1 = std::chrono::steady_clock::now();
+		client.send(ping);
+		std::unique_lock<std::mutex> lock(mtx);
+		cv.wait_for(lock, std::chrono::seconds(5), [&]() { return replies > i; });
+		rtts.push_back(std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - t1).count());
+	}
+	std::sort(rtts.begin(), rtts.end());
+
+	const std::size_t total = 4000;
+	std::string block(1000, 'b');
+	auto t1 = std::chrono::steady_clock::now();
+	for (std::size_t i = 0; i < total; ++i)
+		client.send(block);
+	while (bytes < total * block.size() && std::chrono::steady_clock::now() - t1 < std::chrono::seconds(60))
+		std::this_thread::sleep_for(std::chrono::milliseconds(5));
+	double secs = std::chrono::duration<double>(std::chrono::steady_clock::now() - t1).count();
+
+	printf("%-8s loss=%2.0f%% : rtt p50=%.1fms p99=%.1fms, 4MB in %.2fs (%.2f MB/s)\n", name, loss * 100,
+		rtts[rtts.size() / 2], rtts[rtts.size() * 99 / 100], secs, double(bytes) / 1e6 / secs);
+
+	client.stop();
+	server.stop();
+}
+
+void run_bench_kcp_loss()
+{
+	for (double loss : { 0.0, 0.1 })
+	{
+		bench_kcp_loss_once("default", asio2::kcp_config{}, loss);
+		bench_kcp_loss_once("turbo"  , asio2::kcp_config::turbo(), loss);
+		bench_kcp_loss_once("normal" , asio2::kcp_config::normal(), loss);
+		bench_kcp_loss_once("bulk"   , asio2::kcp_config::bulk(), loss);
+	}
+}
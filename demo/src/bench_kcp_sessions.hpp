@@ -0,0 +1,80 @@
+#pragma once
+
+#include <asio2/asio2.hpp>
+
+// the cpu usage of a kcp server which has many sessions, the sessions are created by raw SYN
+// datagrams from many sockets, so the clients cost nothing. idle : no data is sent, the sessions
+// only run their kcp update. active : the server sends to every session periodically, nobody acks,
+// so every session keeps retransmitting. the server runs on 1 io thread, the cpu usage is measured
+// by std::clock, which is the cpu time of the process on linux. each socket needs a file descriptor,
+// raise the limit (ulimit -n) for the large session counts.
+void bench_kcp_sessions_once(int count)
+{
+	asio2::udp_server server(1024, 65535, 1);
+	std::atomic<int> handshakes{ 0 };
+	server.bind_handshake([&](auto &, asio::error_code ec)
+	{
+		if (!ec)
+			++handshakes;
+	});
+	server.start("127.0.0.1", "18414", asio2::use_kcp);
+
+	asio::io_context ioc;
+	asio::ip::udp::endpoint ep(asio::ip::make_address("127.0.0.1"), 18414);
+	std::vector<std::unique_ptr<asio::ip::udp::socket>> sockets;
+	for (int i = 0; i < count; ++i)
+	{
+		asio::error_code ec;
+		auto socket = std::make_unique<asio::ip::udp::socket>(ioc);
+		socket->open(asio::ip::udp::v4(), ec);
+		if (ec)
+		{
+			printf("open socket %d failed : %s\n", i, ec.message().c_str());
+			break;
+		}
+		socket->set_option(asio::socket_base::receive_buffer_size(4096), ec);
+		asio2::detail::kcp::kcphdr syn = asio2::detail::kcp::make_kcphdr_syn(std::uint32_t(i + 1));
+		socket->send_to(asio::buffer(&syn, sizeof(syn)), ep, 0, ec);
+		sockets.emplace_back(std::move(socket));
+		// don't overflow the receive buffer of the server
+		if (i % 50 == 0)
+			std::this_thread::sleep_for(std::chrono::milliseconds(10));
+	}
+	std::this_thread::sleep_for(std::chrono::milliseconds(1500));
+
+	auto cpu = [](int seconds)
+	{
+		std::clock_t c1 = std::clock();
+		std::this_thread::sleep_for(std::chrono::seconds(seconds));
+		return double(std::clock() - c1) / CLOCKS_PER_SEC / seconds * 100;
+	};
+
+	double idle = cpu(5);
+
+	std::atomic<bool> run{ true };
+	std::thread sender([&]()
+	{
+		while (run)
+		{
+			server.foreach_session([](auto & session_ptr) { session_ptr->send("ping"); });
+			std::this_thread::sleep_for(std::chrono::milliseconds(200));
+		}
+	});
+	std::this_thread::sleep_for(std::chrono::seconds(1));
+
+	double active = cpu(5);
+
+	run = false;
+	sender.join();
+
+	printf("sessions=%zu handshakes=%d : idle cpu %.0f%%, active cpu %.0f%%\n",
+		server.session_count(), (int)handshakes, idle, active);
+
+	server.stop();
+}
+
+void run_bench_kcp_sessions()
+{
+	bench_kcp_sessions_once(2000);
+	bench_kcp_sessions_once(10000);
+}
@@ -0,0 +1,74 @@
+#pragma once
+
+#include <asio2/asio2.hpp>
+
+// 1M async calls with 1 second timeouts, 4000 of them are in flight all the time, each completed
+// call issues the next one. then the server is blocked by a 300 ms function while 100 calls with
+// 100 ms timeouts are pending, they must time out on time.
+void run_bench_rpc_pipeline()
+{
+	asio2::rpc_server server;
+	server.bind("add", [](int a, int b) { return a + b; });
+	server.bind("sleepy", [](int ms) { std::this_thread::sleep_for(std::chrono::milliseconds(ms)); return ms; });
+	server.start("127.0.0.1", "18419", asio2::use_dgram);
+
+	asio2::rpc_client client;
+	if (!client.start("127.0.0.1", "18419", asio2::use_dgram))
+	{
+		printf("connect failed\n");
+		server.stop();
+		return;
+	}
+
+	const int count = 1000000, window = 4000;
+	std::atomic<int> issued{ 0 }, done{ 0 }, bad{ 0 };
+
+	std::function<void()> issue = [&]()
+	{
+		int i = issued++;
+		if (i >= count)
+			return;
+		client.async_call([&, i](asio::error_code ec, int v)
+		{
+			if (ec || v != i + 1)
+				++bad;
+			++done;
+			issue();
+		}, std::chrono::seconds(1), "add", i + 0, 1);
+	};
+
+	auto t1 = std::chrono::steady_clock::now();
+	for (int i = 0; i < window; ++i)
+		issue();
+	while (done < count)
+		std::this_thread::sleep_for(std::chrono::microseconds(200));
+	double secs = std::chrono::duration<double>(std::chrono::steady_clock::now() - t1).count();
+
+	printf("pipelined : %d calls, %d in flight, bad %d, %.0f calls/s\n", count, window, bad.load(), count / secs);
+
+	std::atomic<int> timeouts{ 0 }, finished{ 0 };
+	std::atomic<long> latest{ 0 };
+	auto t2 = std::chrono::steady_clock::now();
+
+	client.async_call([&](asio::error_code, int) { ++finished; }, std::chrono::seconds(2), "sleepy", 300);
+	for (int i = 0; i < 100; ++i)
+	{
+		client.async_call([&](asio::error_code ec, int)
+		{
+			long ms = long(std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - t2).count());
+			if (ec == asio::error::timed_out)
+				++timeouts;
+			if (ms > latest)
+				latest = ms;
+			++finished;
+		}, std::chrono::milliseconds(100), "add", 1, 1);
+	}
+	while (finished < 101)
+		std::this_thread::sleep_for(std::chrono::milliseconds(1));
+
+	printf("timeouts  : %d of 100 calls with 100 ms timeout timed out, the latest at %ld ms\n",
+		timeouts.load(), latest.load());
+
+	client.stop();
+	server.stop();
+}
@@ -0,0 +1,54 @@
+#pragma once
+
+#include <asio2/asio2.hpp>
+
+// encode a request<int, std::string> of "get_user_profile_by_id" into the reused serializer, then
+// decode the header and the arguments of the frame, in the named form and in the compact form.
+void bench_rpc_serialize_once(bool compact)
+{
+	using namespace asio2::detail;
+
+	const int count = 2000000;
+
+	serializer sr;
+	deserializer dr;
+	header head;
+	std::string arg = "hello world";
+	std::size_t sum = 0;
+
+	request<int, std::string&> req(1, "get_user_profile_by_id", 42, arg);
+	if (compact)
+		req.type(rpc_type_req_compact);
+	else
+		req.compact(true);
+
+	auto t1 = std::chrono::steady_clock::now();
+	for (int i = 0; i < count; ++i)
+	{
+		req.id(i);
+		sum += (sr.reset() << req).str().size();
+	}
+	auto t2 = std::chrono::steady_clock::now();
+
+	std::string frame = sr.str();
+	int x = 0;
+	std::string y;
+	for (int i = 0; i < count; ++i)
+	{
+		dr.reset(frame);
+		dr >> head;
+		dr >> x >> y;
+		sum += x + head.id();
+	}
+	auto t3 = std::chrono::steady_clock::now();
+
+	printf("%s : encode %.1f ns, decode %.1f ns, %zu bytes [%zu]\n", compact ? "compact" : "named  ",
+		std::chrono::duration<double, std::nano>(t2 - t1).count() / count,
+		std::chrono::duration<double, std::nano>(t3 - t2).count() / count, frame.size(), sum & 1);
+}
+
+void run_bench_rpc_serialize()
+{
+	bench_rpc_serialize_once(false);
+	bench_rpc_serialize_once(true);
+}
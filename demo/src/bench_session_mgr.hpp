@@ -0,0 +1,80 @@
+#pragma once
+
+#include <asio2/asio2.hpp>
+
+struct bench_session
+{
+	using key_type = std::size_t;
+
+	inline key_type hash_key() const { return this->key; }
+
+	key_type key = 0;
+	bool in_sessions = false;
+};
+
+// the readers look up the sessions by key (like the udp dispatch) while the writer keeps erasing and
+// emplacing the sessions (like the connecting and disconnecting).
+double bench_session_mgr_once(std::size_t shards, std::size_t readers, std::size_t count, int seconds)
+{
+	asio2::detail::io_t io;
+	asio2::detail::session_mgr_t<bench_session> mgr(io, shards);
+	mgr.serialize(false);
+
+	std::vector<std::shared_ptr<bench_session>> sessions(count);
+	for (std::size_t i = 0; i < count; ++i)
+	{
+		sessions[i] = std::make_shared<bench_session>();
+		sessions[i]->key = i + 1;
+		mgr.emplace(sessions[i], [](bool) {});
+	}
+
+	std::atomic<bool> run{ true };
+	std::atomic<std::size_t> lookups{ 0 };
+
+	std::thread writer([&]()
+	{
+		for (std::size_t i = 0; run; ++i)
+		{
+			std::shared_ptr<bench_session> & s = sessions[i % count];
+			mgr.erase(s, [](bool) {});
+			mgr.emplace(s, [](bool) {});
+		}
+	});
+
+	std::vector<std::thread> threads;
+	for (std::size_t r = 0; r < readers; ++r)
+	{
+		threads.emplace_back([&, r]()
+		{
+			std::size_t n = 0, k = r;
+			while (run)
+			{
+				for (int j = 0; j < 1024; ++j, k += 7, ++n)
+					mgr.find(k % count + 1);
+			}
+			lookups += n;
+		});
+	}
+
+	std::this_thread::sleep_for(std::chrono::seconds(seconds));
+	run = false;
+
+	writer.join();
+	for (auto & t : threads)
+		t.join();
+
+	return double(lookups) / 1e6 / seconds;
+}
+
+void run_bench_session_mgr()
+{
+	std::size_t readers = (std::max)(std::size_t(std::thread::hardware_concurrency()), std::size_t(2));
+	std::size_t count = 10000;
+
+	// 1 shard is the single map and the single lock which are used before the sharding
+	for (std::size_t shards = 1; shards <= asio2::detail::session_mgr_t<bench_session>::max_shards; shards *= 2)
+	{
+		double mops = bench_session_mgr_once(shards, readers, count, 2);
+		printf("shards=%-4zu readers=%zu sessions=%zu : %.2f M lookups/s\n", shards, readers, count, mops);
+	}
+}
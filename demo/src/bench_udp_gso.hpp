@@ -0,0 +1,60 @@
+#pragma once
+
+#include <asio2/asio2.hpp>
+
+// one udp_cast sends 200k datagrams of 1000 bytes to another one on the loopback, with the sendmmsg
+// batching, plain and with the UDP_SEGMENT (gso) on send and the UDP_GRO on receive.
+void bench_udp_gso_once(bool gso, bool gro)
+{
+	const long count = 200000;
+
+	asio2::udp_cast sender, receiver;
+	std::atomic<long> received{ 0 }, bad{ 0 }, sent{ 0 };
+
+	receiver.recv_batch(16).recv_gro(gro);
+	receiver.bind_start([&](asio::error_code)
+	{
+		receiver.socket().set_option(asio::socket_base::receive_buffer_size(64 << 20));
+	});
+	receiver.bind_recv([&](asio::ip::udp::endpoint &, std::string_view s)
+	{
+		++received;
+		if (s.size() != 1000 || s.front() != s.back())
+			++bad;
+	});
+	sender.send_batching(64).send_gso(gso);
+
+	sender.start("127.0.0.1", "18412");
+	receiver.start("127.0.0.1", "18413");
+
+	asio::ip::udp::endpoint ep(asio::ip::make_address("127.0.0.1"), 18413);
+
+	auto t1 = std::chrono::steady_clock::now();
+	for (long i = 0; i < count; ++i)
+	{
+		sender.send(ep, std::string(1000, char('a' + i % 26)), [&](std::size_t) { ++sent; });
+		// don't queue too many datagrams ahead of the socket
+		if (i % 2000 == 0)
+			while (sent < i - 20000)
+				std::this_thread::yield();
+	}
+	while (sent < count)
+		std::this_thread::yield();
+	auto t2 = std::chrono::steady_clock::now();
+
+	std::this_thread::sleep_for(std::chrono::milliseconds(500));
+
+	double ms = std::chrono::duration<double, std::milli>(t2 - t1).count();
+	printf("gso=%d(%d) gro=%d : %.0f kpps, received %ld of %ld, bad %ld\n", (int)gso, (int)sender.send_gso(),
+		(int)gro, count / ms, (long)received, count, (long)bad);
+
+	sender.stop();
+	receiver.stop();
+}
+
+void run_bench_udp_gso()
+{
+	bench_udp_gso_once(false, false);
+	bench_udp_gso_once(true, false);
+	bench_udp_gso_once(true, true);
+}
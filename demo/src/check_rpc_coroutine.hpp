@@ -0,0 +1,62 @@
+#pragma once
+
+#include <asio2/asio2.hpp>
+
+#if defined(ASIO2_RPC_COROUTINE)
+
+// the coroutine rpc functions bound on both sides : the server calls the function of the client in
+// the bind_connect, the client calls the function of the server, inline and in an executor. the
+// selfptr of the client is empty, the response of the client must not go through it.
+bool check_rpc_coroutine_once(bool executor)
+{
+	asio::thread_pool pool(2);
+	std::atomic<int> ok{ 0 }, bad{ 0 };
+
+	asio2::rpc_server server;
+	server.bind("sadd", [](int a, int b) -> asio2::rpc_task<int> { co_return a + b; });
+	server.bind_connect([&](auto & session_ptr)
+	{
+		session_ptr->async_call([&](asio::error_code ec, int v)
+		{
+			(!ec && v == 3 ? ok : bad)++;
+		}, std::chrono::seconds(3), "cadd", 1, 2);
+	});
+	if (executor)
+		server.invoke_executor(pool, 1);
+	server.start("127.0.0.1", "18420", asio2::use_dgram);
+
+	asio2::rpc_client client;
+	client.bind("cadd", [](int a, int b) -> asio2::rpc_task<int> { co_return a + b; });
+	if (executor)
+		client.invoke_executor(pool, 1);
+	client.start("127.0.0.1", "18420", asio2::use_dgram);
+
+	for (int i = 0; i < 10; ++i)
+	{
+		client.async_call([&, i](asio::error_code ec, int v)
+		{
+			(!ec && v == i + 1 ? ok : bad)++;
+		}, std::chrono::seconds(3), "sadd", i + 0, 1);
+	}
+
+	auto t1 = std::chrono::steady_clock::now();
+	while (ok + bad < 11 && std::chrono::steady_clock::now() - t1 < std::chrono::seconds(5))
+		std::this_thread::sleep_for(std::chrono::milliseconds(5));
+
+	client.stop();
+	server.stop();
+	pool.join();
+
+	printf("rpc coroutine executor=%d : %d of 11 calls ok, %d bad\n", (int)executor, ok.load(), bad.load());
+
+	return (ok == 11 && bad == 0);
+}
+
+bool check_rpc_coroutine()
+{
+	bool r1 = check_rpc_coroutine_once(false);
+	bool r2 = check_rpc_coroutine_once(true);
+	return (r1 && r2);
+}
+
+#endif